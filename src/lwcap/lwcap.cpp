@@ -25,6 +25,8 @@
 #include <netinet/in.h>
 #include <netinet/ip.h>
 #include <net/if.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
 #include <unistd.h>
 
 #include <QCoreApplication>
@@ -32,35 +34,32 @@
 #include "cmdswitch.h"
 #include "lwcap.h"
 
-bool global_exiting=false;
-
-void SigHandler(int signo)
-{
-  switch(signo) {
-  case SIGTERM:
-  case SIGINT:
-    global_exiting=true;
-    break;
-  }
-}
-
-
 MainObject::MainObject(QObject *parent)
 {
   QString filename;
+  QString peak_filename;
+  unsigned peak_samples=LWCAP_DEFAULT_PEAK_SAMPLES;
+  QString shm_name;
+  unsigned shm_frames=SHMRING_DEFAULT_FRAMES;
+  QString err_msg;
   QHostAddress multicast_address;
   QHostAddress interface_address;
+  QHostAddress unicast_address;
+  unsigned port=LWCAP_DEFAULT_RTP_PORT;
+  int sock;
   unsigned duration=0;
   unsigned channels=2;
   bool ok=false;
 
   main_sndfile=NULL;
+  main_peakfile=NULL;
+  main_shmring=NULL;
 
   CmdSwitch *cmd=new CmdSwitch("lwcap",LWCAP_USAGE);
   for(unsigned i=0;i<cmd->keys();i++) {
     if(cmd->key(i)=="--channels") {
       channels=cmd->value(i).toUInt(&ok);
-      if(!ok) {
+      if((!ok)||(channels==0)) {
 	fprintf(stderr,"lwcap: invalid --channels\n");
 	exit(256);
       }
@@ -86,6 +85,46 @@ MainObject::MainObject(QObject *parent)
       }
       cmd->setProcessed(i,true);
     }
+    if(cmd->key(i)=="--peak-filename") {
+      peak_filename=cmd->value(i);
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--peak-samples") {
+      peak_samples=cmd->value(i).toUInt(&ok);
+      if((!ok)||(peak_samples==0)) {
+	fprintf(stderr,"lwcap: invalid --peak-samples\n");
+	exit(256);
+      }
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--shm-frames") {
+      shm_frames=cmd->value(i).toUInt(&ok);
+      if((!ok)||(shm_frames==0)||((shm_frames&(shm_frames-1))!=0)) {
+	fprintf(stderr,"lwcap: invalid --shm-frames\n");
+	exit(256);
+      }
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--shm-name") {
+      shm_name=cmd->value(i);
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--port") {
+      port=cmd->value(i).toUInt(&ok);
+      if((!ok)||(port==0)||(port>0xFFFF)) {
+	fprintf(stderr,"lwcap: invalid --port\n");
+	exit(256);
+      }
+      cmd->setProcessed(i,true);
+    }
+    if(cmd->key(i)=="--unicast-address") {
+      unicast_address.setAddress(cmd->value(i));
+      if(unicast_address.isNull()||unicast_address.isMulticast()) {
+	fprintf(stderr,"lwcap: invalid --unicast-address\n");
+	exit(256);
+      }
+      cmd->setProcessed(i,true);
+    }
     if(cmd->key(i)=="--interface-address") {
       interface_address.setAddress(cmd->value(i));
       if(interface_address.isNull()) {
@@ -99,15 +138,31 @@ MainObject::MainObject(QObject *parent)
       exit(256);
     }
   }
-  if(multicast_address.isNull()) {
-    fprintf(stderr,"lwcap: no --multicast-address specified\n");
+  if(multicast_address.isNull()==unicast_address.isNull()) {
+    fprintf(stderr,"lwcap: exactly one of --multicast-address or --unicast-address must be specified\n");
     exit(256);
   }
-  if(interface_address.isNull()) {
+  if((!multicast_address.isNull())&&(!multicast_address.isMulticast())) {
+    fprintf(stderr,"lwcap: --multicast-address is not a multicast address\n");
+    exit(256);
+  }
+  if((!multicast_address.isNull())&&interface_address.isNull()) {
     fprintf(stderr,"lwcap: no --interface-address specified\n");
     exit(256);
   }
 
+  //
+  // The ring must be able to hold the largest possible packet
+  //
+  unsigned min_frames=1;
+  while(min_frames<((LWCAP_MAX_DATAGRAM_SIZE/3+channels-1)/channels)) {
+    min_frames*=2;
+  }
+  if(shm_frames<min_frames) {
+    fprintf(stderr,"lwcap: --shm-frames must be at least %u\n",min_frames);
+    exit(256);
+  }
+
   //
   // Open Destination File
   //
@@ -115,6 +170,7 @@ MainObject::MainObject(QObject *parent)
   memset(&sf,0,sizeof(sf));
   sf.samplerate=48000;
   sf.channels=channels;
+  main_channels=channels;
   sf.format=SF_FORMAT_WAV|SF_FORMAT_PCM_24;
 
   if(!filename.isEmpty()) {
@@ -125,13 +181,56 @@ MainObject::MainObject(QObject *parent)
     }
   }
 
+  //
+  // Open Peak File
+  //
+  if(!peak_filename.isEmpty()) {
+    main_peakfile=new PeakFile(sf.samplerate,channels,peak_samples);
+    if(!main_peakfile->open(peak_filename,&err_msg)) {
+      fprintf(stderr,"lwcap: unable to open peak file [%s]\n",
+	      err_msg.toUtf8().constData());
+      exit(256);
+    }
+  }
+
+  //
+  // Open Shared Memory Ring
+  //
+  if(!shm_name.isEmpty()) {
+    std::string shm_err;
+    main_shmring=new ShmRingWriter();
+    if(!main_shmring->open(shm_name.toStdString(),channels,sf.samplerate,
+			   shm_frames,&shm_err)) {
+      fprintf(stderr,"lwcap: unable to create shared memory ring [%s]\n",
+	      shm_err.c_str());
+      exit(256);
+    }
+  }
+
+  //
+  // RTP Socket
+  //
+  if(multicast_address.isNull()) {
+    sock=OpenSocket(unicast_address,port,&err_msg);
+  }
+  else {
+    sock=OpenSocket(multicast_address,port,&err_msg);
+  }
+  if(sock<0) {
+    fprintf(stderr,"lwcap: unable to bind RTP port [%s]\n",
+	    err_msg.toUtf8().constData());
+    exit(256);
+  }
   main_rtp_socket=new QUdpSocket(this);
   connect(main_rtp_socket,SIGNAL(readyRead()),this,SLOT(readyReadData()));
-  if(!main_rtp_socket->bind(5004)) {
-    fprintf(stderr,"unable to bind RTP port [%s]\n",strerror(errno));
+  if(!main_rtp_socket->setSocketDescriptor(sock,QUdpSocket::BoundState,
+					   QIODevice::ReadOnly)) {
+    fprintf(stderr,"lwcap: unable to use RTP socket\n");
     exit(256);
   }
-  Subscribe(multicast_address,interface_address);
+  if(!multicast_address.isNull()) {
+    Subscribe(multicast_address,interface_address);
+  }
 
   //
   // Timers
@@ -142,12 +241,30 @@ MainObject::MainObject(QObject *parent)
   if(duration>0) {
     main_duration_timer->start(duration*1000);
   }
-  main_exit_timer=new QTimer(this);
-  connect(main_exit_timer,SIGNAL(timeout()),this,SLOT(exitData()));
-  main_exit_timer->start(100);
 
-  ::signal(SIGINT,SigHandler);
-  ::signal(SIGTERM,SigHandler);
+  //
+  // Signals
+  //
+  // SIGINT and SIGTERM are blocked and delivered through a signalfd(2)
+  // so that they are serviced by the event loop along with the socket.
+  //
+  sigset_t sigs;
+  sigemptyset(&sigs);
+  sigaddset(&sigs,SIGINT);
+  sigaddset(&sigs,SIGTERM);
+  if(sigprocmask(SIG_BLOCK,&sigs,NULL)!=0) {
+    fprintf(stderr,"lwcap: unable to block signals [%s]\n",strerror(errno));
+    exit(256);
+  }
+  if((main_signal_fd=signalfd(-1,&sigs,SFD_NONBLOCK|SFD_CLOEXEC))<0) {
+    fprintf(stderr,"lwcap: unable to create signalfd [%s]\n",
+	    strerror(errno));
+    exit(256);
+  }
+  main_signal_notifier=
+    new QSocketNotifier(main_signal_fd,QSocketNotifier::Read,this);
+  connect(main_signal_notifier,SIGNAL(activated(int)),
+	  this,SLOT(signalData(int)));
 }
 
 
@@ -155,13 +272,16 @@ void MainObject::readyReadData()
 {
   QHostAddress addr;
   uint16_t port;
-  char data[1501];
+  char data[LWCAP_MAX_DATAGRAM_SIZE+1];
   int64_t n;
 
-  while((n=main_rtp_socket->readDatagram(data,1500,&addr,&port))>0) {
+  while((n=main_rtp_socket->readDatagram(data,LWCAP_MAX_DATAGRAM_SIZE,
+					 &addr,&port))>0) {
+    if(n<12) {
+      continue;  // Too short for an RTP header
+    }
     WritePcm24(data+12,n-12);
   }
-  exitData();
 }
 
 
@@ -174,17 +294,73 @@ void MainObject::errorData(QAbstractSocket::SocketError err)
 
 void MainObject::durationData()
 {
-  sf_close(main_sndfile);
+  CloseFiles();
   exit(0);
 }
 
 
-void MainObject::exitData()
+void MainObject::signalData(int fd)
 {
-  if(global_exiting) {
-    sf_close(main_sndfile);
-    exit(0);
+  struct signalfd_siginfo info;
+
+  while(read(fd,&info,sizeof(info))==sizeof(info)) {
+    switch(info.ssi_signo) {
+    case SIGTERM:
+    case SIGINT:
+      readyReadData();  // Drain anything already queued on the socket
+      CloseFiles();
+      exit(0);
+    }
+  }
+}
+
+
+int MainObject::OpenSocket(const QHostAddress &addr,uint16_t port,
+			   QString *err_msg)
+{
+  int sock;
+  int optval;
+  struct sockaddr_in sa;
+
+  if((sock=socket(AF_INET,SOCK_DGRAM,0))<0) {
+    *err_msg=strerror(errno);
+    return -1;
+  }
+
+  //
+  // For multicast, allow other capture processes to share the port,
+  // bind to the group address itself and disable IP_MULTICAST_ALL so
+  // that the kernel only hands us datagrams for the group we subscribe
+  // to, not those joined by other processes sharing the port. Unicast
+  // sockets are left exclusive, as the kernel would split the stream
+  // between them rather than copy it to each.
+  //
+  if(addr.isMulticast()) {
+    optval=1;
+    if((setsockopt(sock,SOL_SOCKET,SO_REUSEADDR,&optval,sizeof(optval))<0)||
+       (setsockopt(sock,SOL_SOCKET,SO_REUSEPORT,&optval,sizeof(optval))<0)) {
+      *err_msg=strerror(errno);
+      close(sock);
+      return -1;
+    }
+    optval=0;
+    if(setsockopt(sock,IPPROTO_IP,IP_MULTICAST_ALL,&optval,sizeof(optval))<0) {
+      *err_msg=strerror(errno);
+      close(sock);
+      return -1;
+    }
+  }
+  memset(&sa,0,sizeof(sa));
+  sa.sin_family=AF_INET;
+  sa.sin_port=htons(port);
+  sa.sin_addr.s_addr=htonl(addr.toIPv4Address());
+  if(bind(sock,(struct sockaddr *)(&sa),sizeof(sa))<0) {
+    *err_msg=strerror(errno);
+    close(sock);
+    return -1;
   }
+
+  return sock;
 }
 
 
@@ -207,23 +383,57 @@ bool MainObject::Subscribe(const QHostAddress &addr,const QHostAddress &if_addr)
 }
 
 
+void MainObject::CloseFiles()
+{
+  if(main_peakfile!=NULL) {
+    if(!main_peakfile->close()) {
+      fprintf(stderr,"lwcap: error writing peak file\n");
+    }
+  }
+  if(main_sndfile!=NULL) {
+    sf_close(main_sndfile);
+  }
+  if(main_shmring!=NULL) {
+    main_shmring->close();
+  }
+}
+
+
 void MainObject::WritePcm24(const char *data,int bytes)
 {
-  int8_t pcm[1440*4];
+  int32_t pcm[1440];
+  int32_t sample;
+  const uint8_t *src=(const uint8_t *)data;
+  int samples=bytes/3;
+  int frames;
 
+  if(bytes<3*(int)main_channels) {
+    return;
+  }
+  if(samples>1440) {
+    samples=1440;
+  }
+  frames=samples/(int)main_channels;
   if(main_sndfile==NULL) {
     if(write(1,data,bytes)!=1) {
       fprintf(stderr,"lwcap: write to stdout failed\n");
     }
+    if((main_peakfile==NULL)&&(main_shmring==NULL)) {
+      return;
+    }
   }
-  else {
-    for(int i=0;i<(bytes/3);i++) {
-      pcm[4*i]=0;
-      pcm[4*i+1]=data[3*i+2];
-      pcm[4*i+2]=data[3*i+1];
-      pcm[4*i+3]=data[3*i];
+  for(int i=0;i<samples;i++) {
+    sample=(int32_t)(((uint32_t)src[3*i]<<24)|(src[3*i+1]<<16)|(src[3*i+2]<<8));
+    pcm[i]=sample;
+    if(main_peakfile!=NULL) {
+      main_peakfile->addSample(sample);
     }
-    sf_writef_int(main_sndfile,(int32_t *)pcm,bytes/6);
+  }
+  if(main_sndfile!=NULL) {
+    sf_writef_int(main_sndfile,pcm,frames);
+  }
+  if(main_shmring!=NULL) {
+    main_shmring->write(pcm,frames);
   }
 }
 
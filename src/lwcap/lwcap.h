@@ -23,12 +23,19 @@
 #define LWCAP_H
 
 #include <QObject>
+#include <QSocketNotifier>
 #include <QTimer>
 #include <QUdpSocket>
 
 #include <sndfile.h>
 
-#define LWCAP_USAGE "--filename=<outfile> --multicast-address=<ip-addr> --interface-address=<ip-addr>\n"
+#include "peakfile.h"
+#include "shmring.h"
+
+#define LWCAP_USAGE "--filename=<outfile> --multicast-address=<ip-addr>|--unicast-address=<ip-addr> [--interface-address=<ip-addr>] [--port=<port>] [--peak-filename=<peakfile>] [--peak-samples=<samples>] [--shm-name=<name>] [--shm-frames=<frames>]\n"
+#define LWCAP_DEFAULT_PEAK_SAMPLES 256
+#define LWCAP_DEFAULT_RTP_PORT 5004
+#define LWCAP_MAX_DATAGRAM_SIZE 1500
 
 class MainObject : public QObject
 {
@@ -40,15 +47,21 @@ class MainObject : public QObject
   void readyReadData();
   void errorData(QAbstractSocket::SocketError err);
   void durationData();
-  void exitData();
+  void signalData(int fd);
 
  private:
+  int OpenSocket(const QHostAddress &addr,uint16_t port,QString *err_msg);
   bool Subscribe(const QHostAddress &addr,const QHostAddress &if_addr);
+  void CloseFiles();
   void WritePcm24(const char *data,int bytes);
   QUdpSocket *main_rtp_socket;
   SNDFILE *main_sndfile;
+  PeakFile *main_peakfile;
+  ShmRingWriter *main_shmring;
+  unsigned main_channels;
   QTimer *main_duration_timer;
-  QTimer *main_exit_timer;
+  int main_signal_fd;
+  QSocketNotifier *main_signal_notifier;
 };
 
 
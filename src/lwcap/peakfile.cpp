@@ -0,0 +1,238 @@
+// peakfile.cpp
+//
+// Write a multi-resolution waveform peak file.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License as
+//   published by the Free Software Foundation; either version 2 of
+//   the License, or (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <endian.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "peakfile.h"
+
+PeakFile::PeakFile(unsigned samplerate,unsigned chans,
+		   unsigned samples_per_peak)
+{
+  peak_fd=-1;
+  peak_samplerate=samplerate;
+  peak_channels=chans;
+  peak_samples_per_peak=samples_per_peak;
+  peak_chan=0;
+  peak_frames=0;
+  peak_min=new int16_t[chans];
+  peak_max=new int16_t[chans];
+  ResetPeak(peak_min,peak_max);
+  for(unsigned i=0;i<PEAKFILE_LEVELS;i++) {
+    peak_level_min[i]=new int16_t[chans];
+    peak_level_max[i]=new int16_t[chans];
+    ResetPeak(peak_level_min[i],peak_level_max[i]);
+    peak_level_frames[i]=0;
+    peak_level_counts[i]=0;
+    peak_level_offsets[i]=0;
+  }
+  peak_buffer=new int16_t[PEAKFILE_BUFFER_SIZE];
+  peak_buffer_used=0;
+  peak_write_error=false;
+}
+
+
+PeakFile::~PeakFile()
+{
+  if(peak_fd>=0) {
+    close();
+  }
+  delete[] peak_buffer;
+  for(unsigned i=0;i<PEAKFILE_LEVELS;i++) {
+    delete[] peak_level_max[i];
+    delete[] peak_level_min[i];
+  }
+  delete[] peak_max;
+  delete[] peak_min;
+}
+
+
+bool PeakFile::open(const QString &filename,QString *err_msg)
+{
+  if((peak_fd=::open(filename.toUtf8(),O_WRONLY|O_CREAT|O_TRUNC,
+		     S_IRUSR|S_IWUSR|S_IRGRP|S_IWGRP|S_IROTH|S_IWOTH))<0) {
+    *err_msg=strerror(errno);
+    return false;
+  }
+  if((!WriteHeader())||
+     (lseek(peak_fd,PEAKFILE_HEADER_SIZE,SEEK_SET)!=PEAKFILE_HEADER_SIZE)) {
+    *err_msg=strerror(errno);
+    ::close(peak_fd);
+    peak_fd=-1;
+    return false;
+  }
+  peak_write_error=false;
+  return true;
+}
+
+
+bool PeakFile::close()
+{
+  bool ret=true;
+
+  if(peak_fd<0) {
+    return false;
+  }
+
+  //
+  // Flush partial peaks
+  //
+  if((peak_frames>0)||(peak_chan>0)) {
+    AddPeak(0,peak_min,peak_max);
+    ResetPeak(peak_min,peak_max);
+    peak_frames=0;
+    peak_chan=0;
+  }
+  for(unsigned i=1;i<PEAKFILE_LEVELS;i++) {
+    if(peak_level_frames[i]>0) {
+      AddPeak(i,peak_level_min[i],peak_level_max[i]);
+      ResetPeak(peak_level_min[i],peak_level_max[i]);
+      peak_level_frames[i]=0;
+    }
+  }
+  ret=FlushBuffer()&&(!peak_write_error);
+
+  //
+  // Append the upper levels
+  //
+  uint64_t offset=PEAKFILE_HEADER_SIZE+
+    peak_level_counts[0]*2*peak_channels*sizeof(int16_t);
+  for(unsigned i=1;i<PEAKFILE_LEVELS;i++) {
+    size_t len=peak_level_data[i].size()*sizeof(int16_t);
+    peak_level_offsets[i]=offset;
+    if(len>0) {
+      if(pwrite(peak_fd,peak_level_data[i].data(),len,offset)!=(ssize_t)len) {
+	ret=false;
+      }
+    }
+    offset+=len;
+    peak_level_data[i].clear();
+  }
+  if(!WriteHeader()) {
+    ret=false;
+  }
+  ::close(peak_fd);
+  peak_fd=-1;
+
+  return ret;
+}
+
+
+void PeakFile::AddPeak(unsigned level,const int16_t *mins,const int16_t *maxs)
+{
+  if(level==0) {
+    if((peak_buffer_used+2*peak_channels)>PEAKFILE_BUFFER_SIZE) {
+      if(!FlushBuffer()) {
+	peak_write_error=true;  // Reported by close()
+      }
+    }
+    for(unsigned i=0;i<peak_channels;i++) {
+      peak_buffer[peak_buffer_used++]=htole16(mins[i]);
+      peak_buffer[peak_buffer_used++]=htole16(maxs[i]);
+    }
+  }
+  else {
+    for(unsigned i=0;i<peak_channels;i++) {
+      peak_level_data[level].push_back(htole16(mins[i]));
+      peak_level_data[level].push_back(htole16(maxs[i]));
+    }
+  }
+  peak_level_counts[level]++;
+
+  //
+  // Fold into the next coarser level
+  //
+  unsigned next=level+1;
+  if(next<PEAKFILE_LEVELS) {
+    for(unsigned i=0;i<peak_channels;i++) {
+      if(mins[i]<peak_level_min[next][i]) {
+	peak_level_min[next][i]=mins[i];
+      }
+      if(maxs[i]>peak_level_max[next][i]) {
+	peak_level_max[next][i]=maxs[i];
+      }
+    }
+    if(++peak_level_frames[next]==PEAKFILE_LEVEL_FACTOR) {
+      AddPeak(next,peak_level_min[next],peak_level_max[next]);
+      ResetPeak(peak_level_min[next],peak_level_max[next]);
+      peak_level_frames[next]=0;
+    }
+  }
+}
+
+
+void PeakFile::ResetPeak(int16_t *mins,int16_t *maxs) const
+{
+  for(unsigned i=0;i<peak_channels;i++) {
+    mins[i]=32767;
+    maxs[i]=-32768;
+  }
+}
+
+
+bool PeakFile::FlushBuffer()
+{
+  size_t len=peak_buffer_used*sizeof(int16_t);
+
+  peak_buffer_used=0;
+  if(len==0) {
+    return true;
+  }
+  return write(peak_fd,peak_buffer,len)==(ssize_t)len;
+}
+
+
+bool PeakFile::WriteHeader()
+{
+  uint8_t hdr[PEAKFILE_HEADER_SIZE];
+  uint32_t u32;
+  uint64_t u64;
+  unsigned samples=peak_samples_per_peak;
+
+  memset(hdr,0,PEAKFILE_HEADER_SIZE);
+  memcpy(hdr,PEAKFILE_MAGIC,4);
+  u32=htole32(PEAKFILE_VERSION);
+  memcpy(hdr+4,&u32,4);
+  u32=htole32(peak_samplerate);
+  memcpy(hdr+8,&u32,4);
+  u32=htole32(peak_channels);
+  memcpy(hdr+12,&u32,4);
+  u32=htole32(PEAKFILE_LEVELS);
+  memcpy(hdr+16,&u32,4);
+  peak_level_offsets[0]=PEAKFILE_HEADER_SIZE;
+  for(unsigned i=0;i<PEAKFILE_LEVELS;i++) {
+    uint8_t *entry=hdr+24+24*i;
+    u32=htole32(samples);
+    memcpy(entry,&u32,4);
+    u64=htole64(peak_level_offsets[i]);
+    memcpy(entry+8,&u64,8);
+    u64=htole64(peak_level_counts[i]);
+    memcpy(entry+16,&u64,8);
+    samples*=PEAKFILE_LEVEL_FACTOR;
+  }
+
+  return pwrite(peak_fd,hdr,PEAKFILE_HEADER_SIZE,0)==PEAKFILE_HEADER_SIZE;
+}
@@ -0,0 +1,111 @@
+// peakfile.h
+//
+// Write a multi-resolution waveform peak file.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License as
+//   published by the Free Software Foundation; either version 2 of
+//   the License, or (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef PEAKFILE_H
+#define PEAKFILE_H
+
+#include <stdint.h>
+
+#include <vector>
+
+#include <QString>
+
+//
+// File Layout (all values little-endian)
+//
+//  Offset  Size  Field
+//  ------  ----  -----
+//       0     4  Magic ("LWPK")
+//       4     4  Version (1)
+//       8     4  Sample rate
+//      12     4  Channels
+//      16     4  Levels
+//      20     4  Reserved
+//      24    24  Level Table Entry, repeated PEAKFILE_LEVELS times:
+//                  uint32 samples per peak, uint32 reserved,
+//                  uint64 data offset, uint64 peak count
+//
+// Each peak is a min/max pair of signed 16 bit values for each channel,
+// in channel order. Level 0 data begins at PEAKFILE_HEADER_SIZE and is
+// written as the capture proceeds; the remaining levels are appended and
+// the level table filled in when the file is closed. A file that was not
+// closed cleanly will show a count of zero for all levels, in which case
+// level 0 data runs to the end of the file.
+//
+#define PEAKFILE_MAGIC "LWPK"
+#define PEAKFILE_VERSION 1
+#define PEAKFILE_LEVELS 4
+#define PEAKFILE_LEVEL_FACTOR 16
+#define PEAKFILE_HEADER_SIZE 128
+#define PEAKFILE_BUFFER_SIZE 65536
+
+class PeakFile
+{
+ public:
+  PeakFile(unsigned samplerate,unsigned chans,unsigned samples_per_peak);
+  ~PeakFile();
+  bool open(const QString &filename,QString *err_msg);
+  bool close();
+  void addSample(int32_t sample)
+  {
+    int16_t v=sample>>16;
+    if(v<peak_min[peak_chan]) {
+      peak_min[peak_chan]=v;
+    }
+    if(v>peak_max[peak_chan]) {
+      peak_max[peak_chan]=v;
+    }
+    if(++peak_chan==peak_channels) {
+      peak_chan=0;
+      if(++peak_frames==peak_samples_per_peak) {
+	AddPeak(0,peak_min,peak_max);
+	ResetPeak(peak_min,peak_max);
+	peak_frames=0;
+      }
+    }
+  }
+
+ private:
+  void AddPeak(unsigned level,const int16_t *mins,const int16_t *maxs);
+  void ResetPeak(int16_t *mins,int16_t *maxs) const;
+  bool FlushBuffer();
+  bool WriteHeader();
+  int peak_fd;
+  unsigned peak_samplerate;
+  unsigned peak_channels;
+  unsigned peak_samples_per_peak;
+  unsigned peak_chan;
+  unsigned peak_frames;
+  int16_t *peak_min;
+  int16_t *peak_max;
+  int16_t *peak_level_min[PEAKFILE_LEVELS];
+  int16_t *peak_level_max[PEAKFILE_LEVELS];
+  unsigned peak_level_frames[PEAKFILE_LEVELS];
+  uint64_t peak_level_counts[PEAKFILE_LEVELS];
+  uint64_t peak_level_offsets[PEAKFILE_LEVELS];
+  std::vector<int16_t> peak_level_data[PEAKFILE_LEVELS];
+  int16_t *peak_buffer;
+  unsigned peak_buffer_used;
+  bool peak_write_error;
+};
+
+
+#endif  // PEAKFILE_H
@@ -0,0 +1,100 @@
+// shmexample.cpp
+//
+// Example reader for the lwcap(1) shared-memory audio ring.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License as
+//   published by the Free Software Foundation; either version 2 of
+//   the License, or (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+//   Attaches to the ring named on the command line and prints the peak
+//   level of each channel once per second, e.g.
+//
+//     lwcap --multicast-address=239.192.0.1 --interface-address=<addr>
+//           --shm-name=/lwcap-1 &
+//     shmexample /lwcap-1
+//
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "shmring.h"
+
+int main(int argc,char *argv[])
+{
+  ShmRingReader ring;
+  std::string err_msg;
+  const int32_t *pcm;
+  unsigned frames;
+  unsigned chans;
+  unsigned count=0;
+
+  if(argc!=2) {
+    fprintf(stderr,"usage: shmexample <shm-name>\n");
+    exit(1);
+  }
+  if(!ring.open(argv[1],&err_msg)) {
+    fprintf(stderr,"shmexample: unable to attach to \"%s\" [%s]\n",
+	    argv[1],err_msg.c_str());
+    exit(1);
+  }
+  chans=ring.channels();
+  std::vector<int32_t> peaks(chans,0);
+  std::vector<int32_t> local(chans,0);
+
+  while(1) {
+    //
+    // Work directly on the shared memory; no copy is made
+    //
+    while((pcm=ring.peek(&frames))!=NULL&&(frames>0)) {
+      for(unsigned j=0;j<chans;j++) {
+	local[j]=0;
+      }
+      for(unsigned i=0;i<frames;i++) {
+	for(unsigned j=0;j<chans;j++) {
+	  int32_t s=abs(pcm[i*chans+j]>>8);
+	  if(s>local[j]) {
+	    local[j]=s;
+	  }
+	}
+      }
+      if(ring.consume(frames)) {  // Only trust what wasn't overwritten
+	for(unsigned j=0;j<chans;j++) {
+	  if(local[j]>peaks[j]) {
+	    peaks[j]=local[j];
+	  }
+	}
+      }
+      count+=frames;
+      if(count>=ring.sampleRate()) {
+	for(unsigned j=0;j<chans;j++) {
+	  printf("%7.1f ",peaks[j]>0?20.0*log10((double)peaks[j]/8388608.0):
+		 -99.9);
+	  peaks[j]=0;
+	}
+	printf(" dBFS  [%lu overruns]\n",(unsigned long)ring.overruns());
+	fflush(stdout);
+	count=0;
+      }
+    }
+    usleep(10000);
+  }
+
+  return 0;
+}
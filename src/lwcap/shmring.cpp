@@ -0,0 +1,323 @@
+// shmring.cpp
+//
+// Single-writer, multiple-reader PCM ring in POSIX shared memory.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License as
+//   published by the Free Software Foundation; either version 2 of
+//   the License, or (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "shmring.h"
+
+ShmRingWriter::ShmRingWriter()
+{
+  ring_header=NULL;
+  ring_data=NULL;
+  ring_size=0;
+  ring_mask=0;
+}
+
+
+ShmRingWriter::~ShmRingWriter()
+{
+  close();
+}
+
+
+bool ShmRingWriter::open(const std::string &name,unsigned chans,
+			 unsigned samplerate,unsigned frames,
+			 std::string *err_msg)
+{
+  int fd;
+  void *mem;
+
+  if((frames==0)||((frames&(frames-1))!=0)) {
+    *err_msg="ring size must be a power of two";
+    return false;
+  }
+  ring_size=SHMRING_HEADER_SIZE+(size_t)frames*chans*sizeof(int32_t);
+  if((fd=shm_open(name.c_str(),O_RDWR|O_CREAT|O_TRUNC,
+		  S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH))<0) {
+    *err_msg=strerror(errno);
+    return false;
+  }
+  if(ftruncate(fd,ring_size)!=0) {
+    *err_msg=strerror(errno);
+    ::close(fd);
+    shm_unlink(name.c_str());
+    return false;
+  }
+  if((mem=mmap(NULL,ring_size,PROT_READ|PROT_WRITE,MAP_SHARED,fd,0))==
+     MAP_FAILED) {
+    *err_msg=strerror(errno);
+    ::close(fd);
+    shm_unlink(name.c_str());
+    return false;
+  }
+  ::close(fd);
+  ring_name=name;
+  ring_header=(ShmRingHeader *)mem;
+  ring_data=(int32_t *)((uint8_t *)mem+SHMRING_HEADER_SIZE);
+  ring_mask=frames-1;
+
+  ring_header->version=SHMRING_VERSION;
+  ring_header->channels=chans;
+  ring_header->samplerate=samplerate;
+  ring_header->frames=frames;
+  __atomic_store_n(&ring_header->write_pos,0,__ATOMIC_RELEASE);
+  __atomic_store_n(&ring_header->reserve_pos,0,__ATOMIC_RELEASE);
+
+  //
+  // Readers check the magic last, so write it last
+  //
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  memcpy(ring_header->magic,SHMRING_MAGIC,sizeof(ring_header->magic));
+
+  return true;
+}
+
+
+void ShmRingWriter::close()
+{
+  if(ring_header!=NULL) {
+    munmap(ring_header,ring_size);
+    shm_unlink(ring_name.c_str());
+    ring_header=NULL;
+    ring_data=NULL;
+  }
+}
+
+
+void ShmRingWriter::write(const int32_t *pcm,unsigned frames)
+{
+  unsigned chans=ring_header->channels;
+  uint64_t pos=ring_header->write_pos;
+  uint64_t end=pos+frames;
+  unsigned offset;
+  unsigned first;
+
+  //
+  // Announce the region about to be overwritten before touching it
+  //
+  __atomic_store_n(&ring_header->reserve_pos,end,__ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+
+  //
+  // Only the newest frames survive a write larger than the ring
+  //
+  if(frames>(ring_mask+1)) {
+    pcm+=(size_t)(frames-(ring_mask+1))*chans;
+    pos=end-(ring_mask+1);
+    frames=ring_mask+1;
+  }
+  offset=pos&ring_mask;
+  first=frames;
+  if(first>(ring_mask+1-offset)) {
+    first=ring_mask+1-offset;
+  }
+  memcpy(ring_data+offset*chans,pcm,first*chans*sizeof(int32_t));
+  if(first<frames) {
+    memcpy(ring_data,pcm+first*chans,(frames-first)*chans*sizeof(int32_t));
+  }
+
+  __atomic_store_n(&ring_header->write_pos,end,__ATOMIC_RELEASE);
+}
+
+
+ShmRingReader::ShmRingReader()
+{
+  ring_header=NULL;
+  ring_data=NULL;
+  ring_size=0;
+  ring_mask=0;
+  ring_cursor=0;
+  ring_overruns=0;
+}
+
+
+ShmRingReader::~ShmRingReader()
+{
+  close();
+}
+
+
+bool ShmRingReader::open(const std::string &name,std::string *err_msg)
+{
+  int fd;
+  struct stat st;
+  void *mem;
+  const ShmRingHeader *hdr;
+
+  if((fd=shm_open(name.c_str(),O_RDONLY,0))<0) {
+    *err_msg=strerror(errno);
+    return false;
+  }
+  if(fstat(fd,&st)!=0) {
+    *err_msg=strerror(errno);
+    ::close(fd);
+    return false;
+  }
+  if(st.st_size<SHMRING_HEADER_SIZE) {
+    *err_msg="ring not initialized";
+    ::close(fd);
+    return false;
+  }
+  if((mem=mmap(NULL,st.st_size,PROT_READ,MAP_SHARED,fd,0))==MAP_FAILED) {
+    *err_msg=strerror(errno);
+    ::close(fd);
+    return false;
+  }
+  ::close(fd);
+  hdr=(const ShmRingHeader *)mem;
+  if(memcmp(hdr->magic,SHMRING_MAGIC,sizeof(hdr->magic))!=0) {
+    *err_msg="ring not initialized";
+    munmap(mem,st.st_size);
+    return false;
+  }
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  if(hdr->version!=SHMRING_VERSION) {
+    *err_msg="unsupported ring version";
+    munmap(mem,st.st_size);
+    return false;
+  }
+  if((size_t)st.st_size<
+     (SHMRING_HEADER_SIZE+(size_t)hdr->frames*hdr->channels*sizeof(int32_t))) {
+    *err_msg="ring truncated";
+    munmap(mem,st.st_size);
+    return false;
+  }
+  ring_header=hdr;
+  ring_data=(const int32_t *)((const uint8_t *)mem+SHMRING_HEADER_SIZE);
+  ring_size=st.st_size;
+  ring_mask=hdr->frames-1;
+  ring_cursor=__atomic_load_n(&hdr->write_pos,__ATOMIC_ACQUIRE);
+  ring_overruns=0;
+
+  return true;
+}
+
+
+void ShmRingReader::close()
+{
+  if(ring_header!=NULL) {
+    munmap((void *)ring_header,ring_size);
+    ring_header=NULL;
+    ring_data=NULL;
+  }
+}
+
+
+unsigned ShmRingReader::channels() const
+{
+  return ring_header->channels;
+}
+
+
+unsigned ShmRingReader::sampleRate() const
+{
+  return ring_header->samplerate;
+}
+
+
+unsigned ShmRingReader::capacity() const
+{
+  return ring_header->frames;
+}
+
+
+uint64_t ShmRingReader::overruns() const
+{
+  return ring_overruns;
+}
+
+
+const int32_t *ShmRingReader::peek(unsigned *frames)
+{
+  uint64_t wpos=__atomic_load_n(&ring_header->write_pos,__ATOMIC_ACQUIRE);
+  uint64_t avail=wpos-ring_cursor;
+  unsigned offset;
+
+  if(avail>ring_mask) {
+    //
+    // We fell behind, so skip ahead, leaving half the ring as slack
+    // for the writer
+    //
+    uint64_t resync=wpos-(ring_mask+1)/2;
+    ring_overruns+=resync-ring_cursor;
+    ring_cursor=resync;
+    avail=wpos-ring_cursor;
+  }
+  offset=ring_cursor&ring_mask;
+  if(avail>(ring_mask+1-offset)) {
+    avail=ring_mask+1-offset;
+  }
+  *frames=avail;
+
+  return ring_data+offset*ring_header->channels;
+}
+
+
+bool ShmRingReader::consume(unsigned frames)
+{
+  uint64_t rpos;
+  bool ret;
+
+  //
+  // If the writer has started overwriting the region we just read, then
+  // the data that we saw may have been torn
+  //
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  rpos=__atomic_load_n(&ring_header->reserve_pos,__ATOMIC_RELAXED);
+  ret=(rpos-ring_cursor)<=(ring_mask+1);
+  ring_cursor+=frames;
+  if(!ret) {
+    ring_overruns+=frames;
+  }
+
+  return ret;
+}
+
+
+unsigned ShmRingReader::read(int32_t *pcm,unsigned max_frames)
+{
+  unsigned total=0;
+  unsigned frames;
+  const int32_t *data;
+
+  while(total<max_frames) {
+    data=peek(&frames);
+    if(frames==0) {
+      break;
+    }
+    if(frames>(max_frames-total)) {
+      frames=max_frames-total;
+    }
+    memcpy(pcm+total*ring_header->channels,data,
+	   frames*ring_header->channels*sizeof(int32_t));
+    if(!consume(frames)) {
+      break;
+    }
+    total+=frames;
+  }
+
+  return total;
+}
@@ -0,0 +1,103 @@
+// shmring.h
+//
+// Single-writer, multiple-reader PCM ring in POSIX shared memory.
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License as
+//   published by the Free Software Foundation; either version 2 of
+//   the License, or (at your option) any later version.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+//   This file has no Qt dependencies, so that it can be linked into
+//   other programs wishing to consume audio published by lwcap(1).
+//
+
+#ifndef SHMRING_H
+#define SHMRING_H
+
+#include <stdint.h>
+
+#include <string>
+
+//
+// The ring holds interleaved frames of signed 32 bit samples, with the
+// 24 bit PCM value left-justified. The writer advances 'reserve_pos'
+// before copying in new frames and 'write_pos' afterward; both are
+// frame counts since the ring was created and never wrap. Readers keep
+// their own cursor, and can tell that a region was overwritten while they
+// were reading it by checking 'reserve_pos' afterward.
+//
+#define SHMRING_MAGIC "LWSHMRG"
+#define SHMRING_VERSION 1
+#define SHMRING_HEADER_SIZE 128
+#define SHMRING_DEFAULT_FRAMES 65536
+
+struct ShmRingHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t channels;
+  uint32_t samplerate;
+  uint32_t frames;
+  uint8_t reserved1[40];
+  uint64_t write_pos;
+  uint64_t reserve_pos;
+  uint8_t reserved2[48];
+};
+
+
+class ShmRingWriter
+{
+ public:
+  ShmRingWriter();
+  ~ShmRingWriter();
+  bool open(const std::string &name,unsigned chans,unsigned samplerate,
+	    unsigned frames,std::string *err_msg);
+  void close();
+  void write(const int32_t *pcm,unsigned frames);
+
+ private:
+  std::string ring_name;
+  ShmRingHeader *ring_header;
+  int32_t *ring_data;
+  size_t ring_size;
+  uint64_t ring_mask;
+};
+
+
+class ShmRingReader
+{
+ public:
+  ShmRingReader();
+  ~ShmRingReader();
+  bool open(const std::string &name,std::string *err_msg);
+  void close();
+  unsigned channels() const;
+  unsigned sampleRate() const;
+  unsigned capacity() const;
+  uint64_t overruns() const;
+  const int32_t *peek(unsigned *frames);
+  bool consume(unsigned frames);
+  unsigned read(int32_t *pcm,unsigned max_frames);
+
+ private:
+  const ShmRingHeader *ring_header;
+  const int32_t *ring_data;
+  size_t ring_size;
+  uint64_t ring_mask;
+  uint64_t ring_cursor;
+  uint64_t ring_overruns;
+};
+
+
+#endif  // SHMRING_H
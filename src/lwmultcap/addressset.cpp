@@ -0,0 +1,159 @@
+// addressset.cpp
+//
+// A set of IPv4 addresses and CIDR networks for lwmultcap(1)
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <string.h>
+
+#include "addressset.h"
+
+AddressSet::AddressSet()
+{
+  set_mask=0;
+  set_host_count=0;
+  set_has_zero=false;
+}
+
+
+void AddressSet::insert(uint32_t addr,unsigned prefix_len)
+{
+  if(prefix_len>32) {
+    prefix_len=32;
+  }
+  if(prefix_len<32) {
+    addr&=~(0xFFFFFFFFu>>prefix_len);
+  }
+  set_entries.push_back(std::pair<uint32_t,unsigned>(addr,prefix_len));
+  if(prefix_len==32) {
+    InsertHost(addr);
+  }
+  else {
+    InsertNetwork(addr,prefix_len);
+  }
+}
+
+
+bool AddressSet::isEmpty() const
+{
+  return set_entries.empty();
+}
+
+
+unsigned AddressSet::size() const
+{
+  return set_entries.size();
+}
+
+
+const std::vector<std::pair<uint32_t,unsigned> > &AddressSet::entries() const
+{
+  return set_entries;
+}
+
+
+void AddressSet::InsertHost(uint32_t addr)
+{
+  unsigned slot;
+
+  if(set_hosts.empty()) {
+    set_hosts.resize(ADDRESSSET_INITIAL_SIZE,0);
+    set_mask=ADDRESSSET_INITIAL_SIZE-1;
+  }
+  if(addr==0) {
+    set_has_zero=true;
+    return;
+  }
+  slot=Hash(addr,set_mask);
+  while(set_hosts[slot]!=0) {
+    if(set_hosts[slot]==addr) {
+      return;
+    }
+    slot=(slot+1)&set_mask;
+  }
+  if(2*(set_host_count+1)>set_hosts.size()) {
+    Grow();
+    InsertHost(addr);
+    return;
+  }
+  set_hosts[slot]=addr;
+  set_host_count++;
+}
+
+
+void AddressSet::InsertNetwork(uint32_t addr,unsigned prefix_len)
+{
+  unsigned level=prefix_len/8;
+  unsigned span;
+  unsigned first;
+  unsigned node=0;
+  unsigned b;
+
+  if(set_nodes.empty()) {
+    set_nodes.resize(1);
+    memset(&set_nodes[0],0,sizeof(Node));
+  }
+
+  //
+  // A prefix on a byte boundary covers one byte value at the level
+  // above; any other covers a run of them at its own level
+  //
+  if(((prefix_len%8)==0)&&(prefix_len>0)) {
+    level--;
+  }
+  span=1<<(8*(level+1)-prefix_len);
+  first=0xFF&(addr>>(24-8*level));
+
+  //
+  // Walk down to the level, making nodes as needed
+  //
+  for(unsigned i=0;i<level;i++) {
+    b=0xFF&(addr>>(24-8*i));
+    if(set_nodes[node].covered[b]) {
+      return;  // Already within a shorter prefix
+    }
+    if(set_nodes[node].child[b]==0) {
+      set_nodes.resize(set_nodes.size()+1);
+      memset(&set_nodes.back(),0,sizeof(Node));
+      set_nodes[node].child[b]=set_nodes.size()-1;
+    }
+    node=set_nodes[node].child[b];
+  }
+  for(unsigned i=first;i<(first+span);i++) {
+    set_nodes[node].covered[i]=true;
+  }
+}
+
+
+void AddressSet::Grow()
+{
+  std::vector<uint32_t> old;
+  unsigned slot;
+
+  old.swap(set_hosts);
+  set_hosts.resize(2*old.size(),0);
+  set_mask=set_hosts.size()-1;
+  for(unsigned i=0;i<old.size();i++) {
+    if(old.at(i)!=0) {
+      slot=Hash(old.at(i),set_mask);
+      while(set_hosts[slot]!=0) {
+	slot=(slot+1)&set_mask;
+      }
+      set_hosts[slot]=old.at(i);
+    }
+  }
+}
@@ -0,0 +1,104 @@
+// addressset.h
+//
+// A set of IPv4 addresses and CIDR networks for lwmultcap(1)
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef ADDRESSSET_H
+#define ADDRESSSET_H
+
+#include <stdint.h>
+
+#include <utility>
+#include <vector>
+
+#define ADDRESSSET_INITIAL_SIZE 64
+
+//
+// Host addresses (/32) go into an open-addressed hash set, networks into
+// a trie that takes the address a byte at a time. Prefixes that do not
+// fall on a byte boundary are expanded to cover every byte value they
+// match, so contains() costs one hash probe sequence plus at most four
+// trie steps no matter how many entries there are.
+//
+class AddressSet
+{
+ public:
+  AddressSet();
+  void insert(uint32_t addr,unsigned prefix_len=32);
+  bool isEmpty() const;
+  unsigned size() const;
+  const std::vector<std::pair<uint32_t,unsigned> > &entries() const;
+
+  bool contains(uint32_t addr) const
+  {
+    const Node *node;
+
+    if(!set_hosts.empty()) {
+      if(addr==0) {
+	if(set_has_zero) {
+	  return true;
+	}
+      }
+      else {
+	unsigned slot=Hash(addr,set_mask);
+	while(set_hosts[slot]!=0) {
+	  if(set_hosts[slot]==addr) {
+	    return true;
+	  }
+	  slot=(slot+1)&set_mask;
+	}
+      }
+    }
+    if(!set_nodes.empty()) {
+      node=&set_nodes[0];
+      for(int shift=24;shift>=0;shift-=8) {
+	unsigned b=0xFF&(addr>>shift);
+	if(node->covered[b]) {
+	  return true;
+	}
+	if(node->child[b]==0) {
+	  return false;
+	}
+	node=&set_nodes[node->child[b]];
+      }
+    }
+    return false;
+  }
+
+ private:
+  struct Node {
+    unsigned child[256];  // Zero for none, as the root is never a child
+    bool covered[256];
+  };
+  void InsertHost(uint32_t addr);
+  void InsertNetwork(uint32_t addr,unsigned prefix_len);
+  void Grow();
+  static unsigned Hash(uint32_t addr,unsigned mask)
+  {
+    return (unsigned)(((uint64_t)addr*0x9E3779B97F4A7C15ull)>>32)&mask;
+  }
+  std::vector<uint32_t> set_hosts;  // Zero when the slot is empty
+  unsigned set_mask;
+  unsigned set_host_count;
+  bool set_has_zero;
+  std::vector<Node> set_nodes;
+  std::vector<std::pair<uint32_t,unsigned> > set_entries;
+};
+
+
+#endif  // ADDRESSSET_H
@@ -0,0 +1,119 @@
+// advdecoder.cpp
+//
+// Print Livewire advertisements for lwmultcap(1)
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include "advdecoder.h"
+#include "hexdump.h"
+#include "lwadvparser.h"
+
+AdvDecoder::AdvDecoder()
+{
+  adv_json=false;
+  adv_header_printed=false;
+  adv_decoded=0;
+  adv_skipped=0;
+}
+
+
+void AdvDecoder::setJson(bool state)
+{
+  adv_json=state;
+}
+
+
+void AdvDecoder::decode(OutputBuffer *out,const PacketView &pkt)
+{
+  if(accept(out,pkt)) {
+    format(out,pkt);
+  }
+}
+
+
+//
+// Count the packet and, ahead of the first advertisement, print the
+// column headings. Returns false if the packet is not an advertisement.
+//
+bool AdvDecoder::accept(OutputBuffer *out,const PacketView &pkt)
+{
+  LwAdvParser parser(pkt.data(),pkt.size());
+
+  if(!parser.isAdvertisement()) {
+    adv_skipped++;
+    return false;
+  }
+  adv_decoded++;
+  if((!adv_json)&&(!adv_header_printed)) {
+    out->appendf("%-15s %6s  %-15s %5s  %s\n",
+		 "Node","Source","Stream Address","Chans","Name");
+    adv_header_printed=true;
+  }
+  return true;
+}
+
+
+void AdvDecoder::format(OutputBuffer *out,const PacketView &pkt) const
+{
+  LwAdvParser parser(pkt.data(),pkt.size());
+  LwAdvSource src;
+  char node_str[16];
+  char stream_str[16];
+
+  HexDump::formatAddress(node_str,pkt.srcAddress());
+  while(parser.nextSource(&src)) {
+    HexDump::formatAddress(stream_str,src.stream_address);
+    if(adv_json) {
+      out->appendf("{\"time\":%lu.%09lu,\"node\":\"%s\",\"sequence\":%u,"
+		   "\"source\":%u,\"stream_address\":\"%s\",\"channels\":%u,"
+		   "\"name\":",
+		   (unsigned long)(pkt.timestamp()/1000000000),
+		   (unsigned long)(pkt.timestamp()%1000000000),
+		   node_str,parser.sequence(),src.number,stream_str,
+		   src.channels);
+      out->appendJsonString(src.name,src.name_length);
+      out->append("}\n");
+    }
+    else {
+      out->appendf("%-15s %6u  %-15s ",node_str,src.number,stream_str);
+      if(src.channels==0) {
+	out->appendf("%5s  ","-");
+      }
+      else {
+	out->appendf("%5u  ",src.channels);
+      }
+      out->append(src.name,src.name_length);
+      out->append('\n');
+    }
+  }
+  if(parser.isTruncated()&&(!adv_json)) {
+    out->appendf("%-15s (remainder of advertisement not understood)\n",
+		 node_str);
+  }
+}
+
+
+uint64_t AdvDecoder::packetsDecoded() const
+{
+  return adv_decoded;
+}
+
+
+uint64_t AdvDecoder::packetsSkipped() const
+{
+  return adv_skipped;
+}
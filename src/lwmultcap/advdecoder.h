@@ -0,0 +1,53 @@
+// advdecoder.h
+//
+// Print Livewire advertisements for lwmultcap(1)
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef ADVDECODER_H
+#define ADVDECODER_H
+
+#include <stdint.h>
+
+#include "outputbuffer.h"
+#include "packetview.h"
+
+//
+// decode() is accept() followed by format(). The two can be called
+// separately so that format(), which keeps no state, can run on another
+// thread.
+//
+class AdvDecoder
+{
+ public:
+  AdvDecoder();
+  void setJson(bool state);
+  void decode(OutputBuffer *out,const PacketView &pkt);
+  bool accept(OutputBuffer *out,const PacketView &pkt);
+  void format(OutputBuffer *out,const PacketView &pkt) const;
+  uint64_t packetsDecoded() const;
+  uint64_t packetsSkipped() const;
+
+ private:
+  bool adv_json;
+  bool adv_header_printed;
+  uint64_t adv_decoded;
+  uint64_t adv_skipped;
+};
+
+
+#endif  // ADVDECODER_H
@@ -0,0 +1,348 @@
+// bpffilter.cpp
+//
+// Compile lwmultcap(1) packet filters into a classic BPF socket filter
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+
+#include "bpffilter.h"
+
+BpfFilter::BpfFilter()
+{
+  bpf_first_offset=0;
+  bpf_last_offset=-1;
+}
+
+
+void BpfFilter::setFirstOffset(int offset)
+{
+  if(offset>0) {
+    bpf_first_offset=offset;
+  }
+  else {
+    bpf_first_offset=0;
+  }
+}
+
+
+void BpfFilter::setLastOffset(int offset)
+{
+  bpf_last_offset=offset;
+}
+
+
+void BpfFilter::addFilterByte(unsigned offset,uint8_t value)
+{
+  bpf_bytes.push_back(std::pair<unsigned,uint8_t>(offset,value));
+}
+
+
+void BpfFilter::addFilterString(unsigned offset,const char *str,int len)
+{
+  bpf_strings.
+    push_back(std::pair<unsigned,std::string>(offset,std::string(str,len)));
+}
+
+
+void BpfFilter::addFilterSourceAddress(uint32_t addr,unsigned prefix_len)
+{
+  bpf_addresses.push_back(std::pair<uint32_t,unsigned>(addr,prefix_len));
+}
+
+
+void BpfFilter::addExcludeSourceAddress(uint32_t addr,unsigned prefix_len)
+{
+  bpf_excludes.push_back(std::pair<uint32_t,unsigned>(addr,prefix_len));
+}
+
+
+bool BpfFilter::isEmpty() const
+{
+  return bpf_bytes.empty()&&bpf_strings.empty()&&bpf_addresses.empty()&&
+    bpf_excludes.empty();
+}
+
+
+bool BpfFilter::compile(std::string *err_msg)
+{
+  unsigned base=BPFFILTER_UDP_HEADER_SIZE+bpf_first_offset;
+  unsigned limit=0xFFFFFFFF;
+  int group_end;
+  int next;
+
+  bpf_insns.clear();
+  bpf_labels.clear();
+  bpf_program.clear();
+  if(bpf_last_offset>=0) {
+    limit=bpf_last_offset;
+  }
+
+  //
+  // Each filter type is a group of alternatives, any of which may match
+  // (OR); every non-empty group must match (AND). A failed group falls
+  // through to its own 'ret #0' so that no jump has to span more than a
+  // single alternative.
+  //
+
+  //
+  // Filter Bytes
+  //
+  if(!bpf_bytes.empty()) {
+    group_end=NewLabel();
+    for(unsigned i=0;i<bpf_bytes.size();i++) {
+      unsigned offset=bpf_bytes.at(i).first;
+      next=NewLabel();
+      if(offset<limit) {  // Otherwise it can never match
+	EmitLengthCheck(base+offset+1,next);
+	Emit(BPF_LD|BPF_B|BPF_ABS,base+offset);
+	Emit(BPF_JMP|BPF_JEQ|BPF_K,bpf_bytes.at(i).second,LabelNone,next);
+	Emit(BPF_JMP|BPF_JA,0,group_end);
+      }
+      SetLabel(next);
+    }
+    Emit(BPF_RET|BPF_K,0);
+    SetLabel(group_end);
+  }
+
+  //
+  // Filter Strings
+  //
+  if(!bpf_strings.empty()) {
+    group_end=NewLabel();
+    for(unsigned i=0;i<bpf_strings.size();i++) {
+      unsigned offset=bpf_strings.at(i).first;
+      const std::string &str=bpf_strings.at(i).second;
+      unsigned len=str.size();
+      next=NewLabel();
+      if((offset<limit)&&((offset+len)<=limit)) {
+	if(len==0) {
+	  EmitLengthCheck(base+offset+1,next);
+	}
+	else {
+	  EmitLengthCheck(base+offset+len,next);
+	}
+	for(unsigned j=0;j<len;) {
+	  const uint8_t *p=(const uint8_t *)str.c_str()+j;
+	  if((len-j)>=4) {
+	    Emit(BPF_LD|BPF_W|BPF_ABS,base+offset+j);
+	    Emit(BPF_JMP|BPF_JEQ|BPF_K,
+		 ((uint32_t)p[0]<<24)|(p[1]<<16)|(p[2]<<8)|p[3],LabelNone,next);
+	    j+=4;
+	  }
+	  else if((len-j)>=2) {
+	    Emit(BPF_LD|BPF_H|BPF_ABS,base+offset+j);
+	    Emit(BPF_JMP|BPF_JEQ|BPF_K,(p[0]<<8)|p[1],LabelNone,next);
+	    j+=2;
+	  }
+	  else {
+	    Emit(BPF_LD|BPF_B|BPF_ABS,base+offset+j);
+	    Emit(BPF_JMP|BPF_JEQ|BPF_K,p[0],LabelNone,next);
+	    j+=1;
+	  }
+	}
+	Emit(BPF_JMP|BPF_JA,0,group_end);
+      }
+      SetLabel(next);
+    }
+    Emit(BPF_RET|BPF_K,0);
+    SetLabel(group_end);
+  }
+
+  //
+  // Filter Source Addresses
+  //
+  if(!bpf_addresses.empty()) {
+    group_end=NewLabel();
+    for(unsigned i=0;i<bpf_addresses.size();i++) {
+      next=NewLabel();
+      EmitSourceCheck(bpf_addresses.at(i).first,bpf_addresses.at(i).second,
+		      LabelNone,next);
+      Emit(BPF_JMP|BPF_JA,0,group_end);
+      SetLabel(next);
+    }
+    Emit(BPF_RET|BPF_K,0);
+    SetLabel(group_end);
+  }
+
+  //
+  // Exclude Source Addresses
+  //
+  // Any match rejects, so each gets its own 'ret #0'
+  //
+  for(unsigned i=0;i<bpf_excludes.size();i++) {
+    next=NewLabel();
+    EmitSourceCheck(bpf_excludes.at(i).first,bpf_excludes.at(i).second,
+		    LabelNone,next);
+    Emit(BPF_RET|BPF_K,0);
+    SetLabel(next);
+  }
+
+  Emit(BPF_RET|BPF_K,0xFFFFFFFF);
+
+  return Resolve(err_msg);
+}
+
+
+bool BpfFilter::attach(int sock,std::string *err_msg) const
+{
+  struct sock_fprog prog;
+
+  memset(&prog,0,sizeof(prog));
+  prog.len=bpf_program.size();
+  prog.filter=(struct sock_filter *)bpf_program.data();
+  if(setsockopt(sock,SOL_SOCKET,SO_ATTACH_FILTER,&prog,sizeof(prog))<0) {
+    *err_msg=strerror(errno);
+    return false;
+  }
+  return true;
+}
+
+
+void BpfFilter::print(FILE *f) const
+{
+  for(unsigned i=0;i<bpf_program.size();i++) {
+    const struct sock_filter &insn=bpf_program.at(i);
+    fprintf(f,"(%03u) ",i);
+    switch(insn.code) {
+    case BPF_LD|BPF_W|BPF_LEN:
+      fprintf(f,"ld       #pktlen\n");
+      break;
+
+    case BPF_LD|BPF_W|BPF_ABS:
+    case BPF_LD|BPF_H|BPF_ABS:
+    case BPF_LD|BPF_B|BPF_ABS:
+      fprintf(f,"%-8s ",BPF_SIZE(insn.code)==BPF_W?"ld":
+	      (BPF_SIZE(insn.code)==BPF_H?"ldh":"ldb"));
+      if(insn.k>=(uint32_t)SKF_NET_OFF) {
+	fprintf(f,"[net+%u]\n",insn.k-SKF_NET_OFF);
+      }
+      else {
+	fprintf(f,"[%u]\n",insn.k);
+      }
+      break;
+
+    case BPF_JMP|BPF_JEQ|BPF_K:
+    case BPF_JMP|BPF_JGE|BPF_K:
+      fprintf(f,"%-8s #0x%-8x jt %-4u jf %u\n",
+	      BPF_OP(insn.code)==BPF_JEQ?"jeq":"jge",insn.k,
+	      i+1+insn.jt,i+1+insn.jf);
+      break;
+
+    case BPF_ALU|BPF_AND|BPF_K:
+      fprintf(f,"and      #0x%x\n",insn.k);
+      break;
+
+    case BPF_JMP|BPF_JA:
+      fprintf(f,"ja       %u\n",i+1+insn.k);
+      break;
+
+    case BPF_RET|BPF_K:
+      fprintf(f,"ret      #%u\n",insn.k);
+      break;
+
+    default:
+      fprintf(f,"0x%04x %u %u 0x%08x\n",insn.code,insn.jt,insn.jf,insn.k);
+      break;
+    }
+  }
+}
+
+
+int BpfFilter::NewLabel()
+{
+  bpf_labels.push_back(-1);
+  return bpf_labels.size()-1;
+}
+
+
+void BpfFilter::SetLabel(int label)
+{
+  bpf_labels[label]=bpf_insns.size();
+}
+
+
+void BpfFilter::Emit(uint16_t code,uint32_t k,int jt_label,int jf_label)
+{
+  Insn insn;
+
+  insn.code=code;
+  insn.k=k;
+  insn.jt_label=jt_label;
+  insn.jf_label=jf_label;
+  bpf_insns.push_back(insn);
+}
+
+
+void BpfFilter::EmitLengthCheck(unsigned len,int fail_label)
+{
+  Emit(BPF_LD|BPF_W|BPF_LEN,0);
+  Emit(BPF_JMP|BPF_JGE|BPF_K,len,LabelNone,fail_label);
+}
+
+
+void BpfFilter::EmitSourceCheck(uint32_t addr,unsigned prefix_len,
+				int match_label,int next_label)
+{
+  Emit(BPF_LD|BPF_W|BPF_ABS,SKF_NET_OFF+12);
+  if(prefix_len<32) {
+    Emit(BPF_ALU|BPF_AND|BPF_K,
+	 prefix_len==0?0:(0xFFFFFFFFu<<(32-prefix_len)));
+  }
+  Emit(BPF_JMP|BPF_JEQ|BPF_K,addr,match_label,next_label);
+}
+
+
+bool BpfFilter::Resolve(std::string *err_msg)
+{
+  if(bpf_insns.size()>BPF_MAXINSNS) {
+    *err_msg="filter program too long";
+    return false;
+  }
+  for(unsigned i=0;i<bpf_insns.size();i++) {
+    const Insn &insn=bpf_insns.at(i);
+    struct sock_filter out;
+    int jt=0;
+    int jf=0;
+
+    memset(&out,0,sizeof(out));
+    out.code=insn.code;
+    out.k=insn.k;
+    if(insn.jt_label!=LabelNone) {
+      jt=bpf_labels.at(insn.jt_label)-(i+1);
+    }
+    if(insn.jf_label!=LabelNone) {
+      jf=bpf_labels.at(insn.jf_label)-(i+1);
+    }
+    if(insn.code==(BPF_JMP|BPF_JA)) {
+      out.k=jt;
+    }
+    else {
+      if((jt<0)||(jt>255)||(jf<0)||(jf>255)) {
+	*err_msg="filter jump out of range";
+	bpf_program.clear();
+	return false;
+      }
+      out.jt=jt;
+      out.jf=jf;
+    }
+    bpf_program.push_back(out);
+  }
+  return true;
+}
@@ -0,0 +1,81 @@
+// bpffilter.h
+//
+// Compile lwmultcap(1) packet filters into a classic BPF socket filter
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef BPFFILTER_H
+#define BPFFILTER_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include <linux/filter.h>
+
+//
+// A filter attached to a UDP socket sees the packet starting at the UDP
+// header, so payload offsets are relative to this.
+//
+#define BPFFILTER_UDP_HEADER_SIZE 8
+
+class BpfFilter
+{
+ public:
+  BpfFilter();
+  void setFirstOffset(int offset);
+  void setLastOffset(int offset);
+  void addFilterByte(unsigned offset,uint8_t value);
+  void addFilterString(unsigned offset,const char *str,int len);
+  void addFilterSourceAddress(uint32_t addr,unsigned prefix_len=32);
+  void addExcludeSourceAddress(uint32_t addr,unsigned prefix_len=32);
+  bool isEmpty() const;
+  bool compile(std::string *err_msg);
+  bool attach(int sock,std::string *err_msg) const;
+  void print(FILE *f) const;
+
+ private:
+  enum Label {LabelNone=-1};
+  struct Insn {
+    uint16_t code;
+    uint32_t k;
+    int jt_label;
+    int jf_label;
+  };
+  int NewLabel();
+  void SetLabel(int label);
+  void Emit(uint16_t code,uint32_t k,int jt_label=LabelNone,
+	    int jf_label=LabelNone);
+  void EmitLengthCheck(unsigned len,int fail_label);
+  void EmitSourceCheck(uint32_t addr,unsigned prefix_len,int match_label,
+		       int next_label);
+  bool Resolve(std::string *err_msg);
+  unsigned bpf_first_offset;
+  int bpf_last_offset;
+  std::vector<std::pair<unsigned,uint8_t> > bpf_bytes;
+  std::vector<std::pair<unsigned,std::string> > bpf_strings;
+  std::vector<std::pair<uint32_t,unsigned> > bpf_addresses;
+  std::vector<std::pair<uint32_t,unsigned> > bpf_excludes;
+  std::vector<Insn> bpf_insns;
+  std::vector<int> bpf_labels;
+  std::vector<struct sock_filter> bpf_program;
+};
+
+
+#endif  // BPFFILTER_H
@@ -0,0 +1,525 @@
+// capturereader.cpp
+//
+// Read UDP/IPv4 packets from a pcap or pcapng file for lwmultcap(1)
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "capturereader.h"
+
+#define CAPTUREREADER_PCAP_MAGIC 0xA1B2C3D4
+#define CAPTUREREADER_PCAP_NS_MAGIC 0xA1B23C4D
+#define CAPTUREREADER_PCAP_HEADER_SIZE 24
+#define CAPTUREREADER_PCAP_RECORD_SIZE 16
+#define CAPTUREREADER_SHB_TYPE 0x0A0D0D0A
+#define CAPTUREREADER_IDB_TYPE 0x00000001
+#define CAPTUREREADER_SPB_TYPE 0x00000003
+#define CAPTUREREADER_EPB_TYPE 0x00000006
+#define CAPTUREREADER_BYTE_ORDER_MAGIC 0x1A2B3C4D
+
+//
+// Link Types
+//
+#define CAPTUREREADER_LINKTYPE_NULL 0
+#define CAPTUREREADER_LINKTYPE_ETHERNET 1
+#define CAPTUREREADER_LINKTYPE_RAW 101
+#define CAPTUREREADER_LINKTYPE_LINUX_SLL 113
+#define CAPTUREREADER_LINKTYPE_IPV4 228
+#define CAPTUREREADER_LINKTYPE_LINUX_SLL2 276
+
+static inline uint16_t GetNet16(const uint8_t *p)
+{
+  return ((uint16_t)p[0]<<8)|p[1];
+}
+
+
+static inline uint32_t GetNet32(const uint8_t *p)
+{
+  return ((uint32_t)p[0]<<24)|((uint32_t)p[1]<<16)|((uint32_t)p[2]<<8)|p[3];
+}
+
+
+CaptureReader::CaptureReader()
+{
+  cap_data=NULL;
+  cap_size=0;
+  cap_pos=0;
+  cap_format=CaptureReader::FormatPcap;
+  cap_swapped=false;
+  cap_truncated=false;
+  cap_linktype=0;
+  cap_ts_scale=1000;
+  cap_read=0;
+  cap_skipped=0;
+}
+
+
+CaptureReader::~CaptureReader()
+{
+  close();
+}
+
+
+bool CaptureReader::open(const std::string &filename,std::string *err_msg)
+{
+  int fd;
+  struct stat st;
+  void *mem;
+  uint32_t magic;
+
+  if((fd=::open(filename.c_str(),O_RDONLY))<0) {
+    *err_msg=strerror(errno);
+    return false;
+  }
+  if(fstat(fd,&st)!=0) {
+    *err_msg=strerror(errno);
+    ::close(fd);
+    return false;
+  }
+  if(st.st_size<CAPTUREREADER_PCAP_HEADER_SIZE) {
+    *err_msg="not a pcap or pcapng file";
+    ::close(fd);
+    return false;
+  }
+  if((mem=mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,fd,0))==MAP_FAILED) {
+    *err_msg=strerror(errno);
+    ::close(fd);
+    return false;
+  }
+  ::close(fd);
+  madvise(mem,st.st_size,MADV_SEQUENTIAL);
+  cap_data=(const uint8_t *)mem;
+  cap_size=st.st_size;
+  cap_pos=0;
+  cap_truncated=false;
+  cap_error.clear();
+  cap_read=0;
+  cap_skipped=0;
+  cap_interfaces.clear();
+
+  //
+  // The magic number says both the format and the byte order
+  //
+  memcpy(&magic,cap_data,4);
+  if((magic==CAPTUREREADER_PCAP_MAGIC)||
+     (__builtin_bswap32(magic)==CAPTUREREADER_PCAP_MAGIC)) {
+    cap_format=CaptureReader::FormatPcap;
+    cap_swapped=magic!=CAPTUREREADER_PCAP_MAGIC;
+    cap_ts_scale=1000;
+  }
+  else if((magic==CAPTUREREADER_PCAP_NS_MAGIC)||
+	  (__builtin_bswap32(magic)==CAPTUREREADER_PCAP_NS_MAGIC)) {
+    cap_format=CaptureReader::FormatPcap;
+    cap_swapped=magic!=CAPTUREREADER_PCAP_NS_MAGIC;
+    cap_ts_scale=1;
+  }
+  else if(magic==CAPTUREREADER_SHB_TYPE) {
+    cap_format=CaptureReader::FormatPcapng;
+    if(!ReadSectionHeader(cap_data,cap_size)) {
+      *err_msg="invalid pcapng section header";
+      close();
+      return false;
+    }
+    return true;
+  }
+  else {
+    *err_msg="not a pcap or pcapng file";
+    close();
+    return false;
+  }
+  cap_linktype=Get32(cap_data+20);
+  cap_pos=CAPTUREREADER_PCAP_HEADER_SIZE;
+
+  return true;
+}
+
+
+void CaptureReader::close()
+{
+  if(cap_data!=NULL) {
+    munmap((void *)cap_data,cap_size);
+    cap_data=NULL;
+    cap_size=0;
+  }
+}
+
+
+bool CaptureReader::next(PacketView *pkt)
+{
+  if(cap_data==NULL) {
+    return false;
+  }
+  if(cap_format==CaptureReader::FormatPcapng) {
+    return NextPcapng(pkt);
+  }
+  return NextPcap(pkt);
+}
+
+
+bool CaptureReader::isTruncated() const
+{
+  return cap_truncated;
+}
+
+
+std::string CaptureReader::errorString() const
+{
+  return cap_error;
+}
+
+
+uint64_t CaptureReader::packetsRead() const
+{
+  return cap_read;
+}
+
+
+uint64_t CaptureReader::packetsSkipped() const
+{
+  return cap_skipped;
+}
+
+
+bool CaptureReader::NextPcap(PacketView *pkt)
+{
+  const uint8_t *rec;
+  uint32_t caplen;
+  uint64_t ts;
+
+  while((cap_pos+CAPTUREREADER_PCAP_RECORD_SIZE)<=cap_size) {
+    rec=cap_data+cap_pos;
+    caplen=Get32(rec+8);
+    if(caplen>(cap_size-cap_pos-CAPTUREREADER_PCAP_RECORD_SIZE)) {
+      cap_truncated=true;
+      cap_pos=cap_size;
+      return false;
+    }
+    cap_pos+=CAPTUREREADER_PCAP_RECORD_SIZE+caplen;
+    ts=(uint64_t)Get32(rec)*1000000000+(uint64_t)Get32(rec+4)*cap_ts_scale;
+    if(Decode(pkt,cap_linktype,rec+CAPTUREREADER_PCAP_RECORD_SIZE,caplen,
+	      ts)) {
+      return true;
+    }
+  }
+  if(cap_pos<cap_size) {
+    cap_truncated=true;
+    cap_pos=cap_size;
+  }
+  return false;
+}
+
+
+bool CaptureReader::NextPcapng(PacketView *pkt)
+{
+  const uint8_t *block;
+  uint32_t type;
+  uint32_t len;
+  uint32_t iface;
+  uint32_t caplen;
+  uint64_t ts;
+
+  while((cap_pos+12)<=cap_size) {
+    block=cap_data+cap_pos;
+    if(GetNet32(block)==CAPTUREREADER_SHB_TYPE) {  // Same either way round
+      if(!ReadSectionHeader(block,cap_size-cap_pos)) {
+	cap_truncated=true;
+	cap_pos=cap_size;
+	return false;
+      }
+      continue;
+    }
+    type=Get32(block);
+    len=Get32(block+4);
+    if((len<12)||((len&3)!=0)||(len>(cap_size-cap_pos))) {
+      cap_truncated=true;
+      cap_pos=cap_size;
+      return false;
+    }
+    cap_pos+=len;
+    switch(type) {
+    case CAPTUREREADER_IDB_TYPE:
+      if(!ReadInterface(block,len)) {
+	cap_error="unsupported timestamp resolution";
+	cap_pos=cap_size;
+	return false;
+      }
+      break;
+
+    case CAPTUREREADER_EPB_TYPE:
+      if(len<32) {
+	break;
+      }
+      iface=Get32(block+8);
+      caplen=Get32(block+20);
+      if((iface>=cap_interfaces.size())||(caplen>(len-32))) {
+	cap_read++;
+	cap_skipped++;
+	break;
+      }
+      ts=((uint64_t)Get32(block+12)<<32)|Get32(block+16);
+      if(Decode(pkt,cap_interfaces.at(iface).linktype,block+28,caplen,
+		ToNanoseconds(ts,cap_interfaces.at(iface).tsresol))) {
+	return true;
+      }
+      break;
+
+    case CAPTUREREADER_SPB_TYPE:
+      //
+      // No timestamp, and always interface zero
+      //
+      if((len<16)||cap_interfaces.empty()) {
+	break;
+      }
+      caplen=Get32(block+8);
+      if(caplen>(len-16)) {
+	caplen=len-16;
+      }
+      if(Decode(pkt,cap_interfaces.at(0).linktype,block+12,caplen,0)) {
+	return true;
+      }
+      break;
+    }
+  }
+  if(cap_pos<cap_size) {
+    cap_truncated=true;
+    cap_pos=cap_size;
+  }
+  return false;
+}
+
+
+bool CaptureReader::ReadSectionHeader(const uint8_t *block,uint32_t len)
+{
+  uint32_t magic;
+  uint32_t block_len;
+
+  if(len<28) {
+    return false;
+  }
+  memcpy(&magic,block+8,4);
+  if(magic==CAPTUREREADER_BYTE_ORDER_MAGIC) {
+    cap_swapped=false;
+  }
+  else if(__builtin_bswap32(magic)==CAPTUREREADER_BYTE_ORDER_MAGIC) {
+    cap_swapped=true;
+  }
+  else {
+    return false;
+  }
+  block_len=Get32(block+4);
+  if((block_len<28)||((block_len&3)!=0)||(block_len>len)) {
+    return false;
+  }
+
+  //
+  // Interface numbering starts over in each section
+  //
+  cap_interfaces.clear();
+  cap_pos+=block_len;
+
+  return true;
+}
+
+
+bool CaptureReader::ReadInterface(const uint8_t *block,uint32_t len)
+{
+  Interface iface;
+  uint32_t pos=16;
+  uint16_t code;
+  uint16_t optlen;
+
+  iface.linktype=0xFFFF;
+  iface.tsresol=6;
+  if(len>=20) {
+    iface.linktype=Get16(block+8);
+    while((pos+4)<=(len-4)) {
+      code=Get16(block+pos);
+      optlen=Get16(block+pos+2);
+      if((code==0)||((pos+4+optlen)>(len-4))) {  // opt_endofopt
+	break;
+      }
+      if((code==9)&&(optlen>=1)) {  // if_tsresol
+	iface.tsresol=block[pos+4];
+
+	//
+	// Anything finer than this overflows the 64 bit scale factor
+	//
+	if((iface.tsresol&0x80)!=0) {
+	  if((iface.tsresol&0x7F)>63) {
+	    return false;
+	  }
+	}
+	else if(iface.tsresol>19) {
+	  return false;
+	}
+      }
+      pos+=4+((optlen+3)&~3u);
+    }
+  }
+  cap_interfaces.push_back(iface);
+
+  return true;
+}
+
+
+bool CaptureReader::Decode(PacketView *pkt,uint16_t linktype,
+			   const uint8_t *frame,uint32_t len,uint64_t timestamp)
+{
+  uint32_t offset=0;
+  uint16_t ethertype=0x0800;
+  uint32_t ihl;
+  uint32_t ip_len;
+  uint32_t udp_len;
+  const uint8_t *ip;
+  const uint8_t *udp;
+
+  cap_read++;
+
+  //
+  // Find the IP header
+  //
+  switch(linktype) {
+  case CAPTUREREADER_LINKTYPE_NULL:
+    //
+    // Address family, in the byte order of the capturing host
+    //
+    if((len<4)||((frame[0]!=2)&&(frame[3]!=2))) {
+      cap_skipped++;
+      return false;
+    }
+    offset=4;
+    break;
+
+  case CAPTUREREADER_LINKTYPE_ETHERNET:
+    offset=14;
+    if(len<offset) {
+      cap_skipped++;
+      return false;
+    }
+    ethertype=GetNet16(frame+12);
+    while(((ethertype==0x8100)||(ethertype==0x88A8))&&(len>=(offset+4))) {
+      ethertype=GetNet16(frame+offset+2);
+      offset+=4;
+    }
+    break;
+
+  case CAPTUREREADER_LINKTYPE_RAW:
+  case CAPTUREREADER_LINKTYPE_IPV4:
+    break;
+
+  case CAPTUREREADER_LINKTYPE_LINUX_SLL:
+    offset=16;
+    if(len<offset) {
+      cap_skipped++;
+      return false;
+    }
+    ethertype=GetNet16(frame+14);
+    break;
+
+  case CAPTUREREADER_LINKTYPE_LINUX_SLL2:
+    offset=20;
+    if(len<offset) {
+      cap_skipped++;
+      return false;
+    }
+    ethertype=GetNet16(frame);
+    break;
+
+  default:
+    cap_skipped++;
+    return false;
+  }
+  if((ethertype!=0x0800)||((len-offset)<20)) {
+    cap_skipped++;
+    return false;
+  }
+
+  //
+  // IPv4, unfragmented UDP only
+  //
+  ip=frame+offset;
+  ihl=4*(ip[0]&0x0F);
+  ip_len=GetNet16(ip+2);
+  if(((ip[0]>>4)!=4)||(ihl<20)||(ip[9]!=17)||
+     ((GetNet16(ip+6)&0x3FFF)!=0)) {
+    cap_skipped++;
+    return false;
+  }
+  if(ip_len>(len-offset)) {
+    ip_len=len-offset;  // Snapped
+  }
+  if(ip_len<(ihl+8)) {
+    cap_skipped++;
+    return false;
+  }
+  udp=ip+ihl;
+  udp_len=GetNet16(udp+4);
+  if((udp_len<8)||(udp_len>(ip_len-ihl))) {
+    udp_len=ip_len-ihl;
+  }
+
+  *pkt=PacketView((const char *)udp+8,udp_len-8);
+  pkt->setSource(GetNet32(ip+12),GetNet16(udp));
+  pkt->setDestination(GetNet32(ip+16),GetNet16(udp+2));
+  pkt->setTimestamp(timestamp);
+
+  return true;
+}
+
+
+uint16_t CaptureReader::Get16(const uint8_t *p) const
+{
+  uint16_t val;
+
+  memcpy(&val,p,2);
+  return cap_swapped?__builtin_bswap16(val):val;
+}
+
+
+uint32_t CaptureReader::Get32(const uint8_t *p) const
+{
+  uint32_t val;
+
+  memcpy(&val,p,4);
+  return cap_swapped?__builtin_bswap32(val):val;
+}
+
+
+uint64_t CaptureReader::ToNanoseconds(uint64_t ts,unsigned tsresol)
+{
+  uint64_t scale=1;
+
+  if((tsresol&0x80)!=0) {
+    return (uint64_t)(((unsigned __int128)ts*1000000000)>>(tsresol&0x7F));
+  }
+  if(tsresol<=9) {
+    for(unsigned i=tsresol;i<9;i++) {
+      scale*=10;
+    }
+    return ts*scale;
+  }
+  for(unsigned i=9;i<tsresol;i++) {
+    scale*=10;
+  }
+  return ts/scale;
+}
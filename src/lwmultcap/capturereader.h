@@ -0,0 +1,81 @@
+// capturereader.h
+//
+// Read UDP/IPv4 packets from a pcap or pcapng file for lwmultcap(1)
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef CAPTUREREADER_H
+#define CAPTUREREADER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "packetview.h"
+
+//
+// The whole file is mapped read-only and records are parsed where they
+// lie, so the views handed out by next() point straight into the mapping
+// and stay valid until close(). Anything that is not an unfragmented
+// UDP/IPv4 datagram on a supported link type is skipped and counted.
+//
+class CaptureReader
+{
+ public:
+  CaptureReader();
+  ~CaptureReader();
+  bool open(const std::string &filename,std::string *err_msg);
+  void close();
+  bool next(PacketView *pkt);
+  bool isTruncated() const;
+  std::string errorString() const;
+  uint64_t packetsRead() const;
+  uint64_t packetsSkipped() const;
+
+ private:
+  enum Format {FormatPcap=0,FormatPcapng=1};
+  struct Interface {
+    uint16_t linktype;
+    unsigned tsresol;  // Power of ten, or of two if 0x80 is set
+  };
+  bool NextPcap(PacketView *pkt);
+  bool NextPcapng(PacketView *pkt);
+  bool ReadSectionHeader(const uint8_t *block,uint32_t len);
+  bool ReadInterface(const uint8_t *block,uint32_t len);
+  bool Decode(PacketView *pkt,uint16_t linktype,const uint8_t *frame,
+	      uint32_t len,uint64_t timestamp);
+  uint16_t Get16(const uint8_t *p) const;
+  uint32_t Get32(const uint8_t *p) const;
+  static uint64_t ToNanoseconds(uint64_t ts,unsigned tsresol);
+  const uint8_t *cap_data;
+  size_t cap_size;
+  size_t cap_pos;
+  Format cap_format;
+  bool cap_swapped;
+  bool cap_truncated;
+  std::string cap_error;
+  uint16_t cap_linktype;
+  unsigned cap_ts_scale;
+  std::vector<Interface> cap_interfaces;
+  uint64_t cap_read;
+  uint64_t cap_skipped;
+};
+
+
+#endif  // CAPTUREREADER_H
@@ -0,0 +1,236 @@
+// deltadump.cpp
+//
+// Print only what changed from one packet to the next for lwmultcap(1)
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <stdio.h>
+#include <string.h>
+
+#include "deltadump.h"
+
+DeltaDump::DeltaDump(const HexDump *hexdump)
+{
+  Entry empty;
+
+  delta_hexdump=hexdump;
+  delta_show_ruler=true;
+  memset(&empty,0,sizeof(empty));
+  delta_entries.resize(DELTADUMP_INITIAL_SIZE,empty);
+  delta_mask=DELTADUMP_INITIAL_SIZE-1;
+  delta_rows.reserve((DELTADUMP_MAX_PAYLOAD+15)/16);
+  delta_range_count=0;
+  delta_unchanged=0;
+}
+
+
+void DeltaDump::setShowRuler(bool state)
+{
+  delta_show_ruler=state;
+}
+
+
+void DeltaDump::format(OutputBuffer *out,const PacketView &pkt,int64_t delta)
+{
+  char src_str[24];
+  char dst_str[24];
+  char str[128];
+  bool created=false;
+  Payload *p=Find(pkt.srcAddress(),pkt.srcPort(),&created);
+  int len=pkt.size();
+  unsigned changed;
+
+  if(len>DELTADUMP_MAX_PAYLOAD) {
+    len=DELTADUMP_MAX_PAYLOAD;
+  }
+
+  //
+  // Nothing to compare against yet, so show the lot
+  //
+  if(created) {
+    delta_hexdump->formatPacket(out,pkt.dstAddress(),pkt.dstPort(),
+				pkt.srcAddress(),pkt.srcPort(),
+				pkt.data(),len,pkt.timestamp(),delta);
+    memcpy(p->data,pkt.data(),len);
+    p->len=len;
+    return;
+  }
+
+  changed=Compare(p->data,p->len,pkt.data(),len);
+  if((changed==0)&&(p->len==len)) {
+    HexDump::formatAddress(src_str,pkt.srcAddress(),pkt.srcPort());
+    HexDump::formatAddress(dst_str,pkt.dstAddress(),pkt.dstPort());
+    out->appendf("[%s -> %s unchanged]\n",src_str,dst_str);
+    delta_unchanged++;
+    return;
+  }
+
+  FormatSummary(str,changed,p->len,len);
+  if(delta_show_ruler) {
+    delta_hexdump->formatHeader(out,pkt.dstAddress(),pkt.dstPort(),
+				pkt.srcAddress(),pkt.srcPort(),len,
+				pkt.timestamp(),delta);
+  }
+  else {
+    out->appendf("%s\n",str);
+  }
+  for(unsigned i=0;i<delta_rows.size();i++) {
+    delta_hexdump->formatRow(out,pkt.data(),len,delta_rows.at(i));
+  }
+  if(delta_show_ruler) {
+    delta_hexdump->formatFooter(out);
+    out->appendf("| %-74s |\n",str);
+    delta_hexdump->formatFooter(out);
+  }
+  memcpy(p->data,pkt.data(),len);
+  p->len=len;
+}
+
+
+uint64_t DeltaDump::packetsUnchanged() const
+{
+  return delta_unchanged;
+}
+
+
+DeltaDump::Payload *DeltaDump::Find(uint32_t addr,uint16_t port,
+				    bool *created)
+{
+  //
+  // Keyed and hashed the same way as in SourceStats
+  //
+  uint64_t key=0x1000000000000ull|((uint64_t)addr<<16)|port;
+  unsigned slot=(unsigned)((key*0x9E3779B97F4A7C15ull)>>32)&delta_mask;
+
+  while((delta_entries[slot].key!=0)&&(delta_entries[slot].key!=key)) {
+    slot=(slot+1)&delta_mask;
+  }
+  if(delta_entries[slot].key==0) {
+    if(2*(delta_payloads.size()+1)>delta_entries.size()) {
+      Grow();
+      return Find(addr,port,created);
+    }
+    delta_entries[slot].key=key;
+    delta_entries[slot].payload=delta_payloads.size();
+    delta_payloads.push_back(Payload());
+    delta_payloads.back().len=0;
+    *created=true;
+  }
+  return &delta_payloads[delta_entries[slot].payload];
+}
+
+
+void DeltaDump::Grow()
+{
+  std::vector<Entry> old;
+  Entry empty;
+  unsigned slot;
+
+  memset(&empty,0,sizeof(empty));
+  old.swap(delta_entries);
+  delta_entries.resize(2*old.size(),empty);
+  delta_mask=delta_entries.size()-1;
+  for(unsigned i=0;i<old.size();i++) {
+    if(old.at(i).key!=0) {
+      slot=(unsigned)((old.at(i).key*0x9E3779B97F4A7C15ull)>>32)&delta_mask;
+      while(delta_entries[slot].key!=0) {
+	slot=(slot+1)&delta_mask;
+      }
+      delta_entries[slot]=old.at(i);
+    }
+  }
+}
+
+
+unsigned DeltaDump::Compare(const char *old_data,int old_len,
+			    const char *new_data,int new_len)
+{
+  int common=old_len<new_len?old_len:new_len;
+  unsigned changed=0;
+  uint64_t old_words[2];
+  uint64_t new_words[2];
+  bool row_changed;
+
+  delta_rows.clear();
+  delta_range_count=0;
+  for(int i=0;i<new_len;i+=16) {
+    //
+    // Whole rows present in both payloads can be skipped a word at a time
+    //
+    if((i+16)<=common) {
+      memcpy(old_words,old_data+i,16);
+      memcpy(new_words,new_data+i,16);
+      if(((old_words[0]^new_words[0])|(old_words[1]^new_words[1]))==0) {
+	continue;
+      }
+    }
+    row_changed=false;
+    for(int j=i;(j<(i+16))&&(j<new_len);j++) {
+      if((j>=common)||(old_data[j]!=new_data[j])) {
+	changed++;
+	row_changed=true;
+	if((delta_range_count>0)&&
+	   (delta_range_count<=DELTADUMP_MAX_RANGES)&&
+	   (delta_ranges[delta_range_count-1][1]==(unsigned)(j-1))) {
+	  delta_ranges[delta_range_count-1][1]=j;
+	}
+	else {
+	  if(delta_range_count<DELTADUMP_MAX_RANGES) {
+	    delta_ranges[delta_range_count][0]=j;
+	    delta_ranges[delta_range_count][1]=j;
+	  }
+	  if(delta_range_count<=DELTADUMP_MAX_RANGES) {
+	    delta_range_count++;  // One past the end means "and more"
+	  }
+	}
+      }
+    }
+    if(row_changed) {
+      delta_rows.push_back(i);
+    }
+  }
+
+  return changed;
+}
+
+
+void DeltaDump::FormatSummary(char *str,unsigned changed,int old_len,
+			      int new_len) const
+{
+  unsigned ranges=delta_range_count;
+  int n;
+
+  if(ranges>DELTADUMP_MAX_RANGES) {
+    ranges=DELTADUMP_MAX_RANGES;
+  }
+  n=sprintf(str,"%u byte(s) changed",changed);
+  for(unsigned i=0;i<ranges;i++) {
+    if(delta_ranges[i][0]==delta_ranges[i][1]) {
+      n+=sprintf(str+n,"%s0x%04X",i==0?" at ":", ",delta_ranges[i][0]);
+    }
+    else {
+      n+=sprintf(str+n,"%s0x%04X-0x%04X",i==0?" at ":", ",
+		 delta_ranges[i][0],delta_ranges[i][1]);
+    }
+  }
+  if(delta_range_count>DELTADUMP_MAX_RANGES) {
+    n+=sprintf(str+n,", ...");
+  }
+  if(old_len!=new_len) {
+    sprintf(str+n,", size was 0x%04X",old_len);
+  }
+}
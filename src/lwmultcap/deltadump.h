@@ -0,0 +1,79 @@
+// deltadump.h
+//
+// Print only what changed from one packet to the next for lwmultcap(1)
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef DELTADUMP_H
+#define DELTADUMP_H
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "hexdump.h"
+#include "outputbuffer.h"
+#include "packetview.h"
+
+#define DELTADUMP_INITIAL_SIZE 64
+#define DELTADUMP_MAX_PAYLOAD 1500
+#define DELTADUMP_MAX_RANGES 2
+
+//
+// The last payload from each source address and port is kept in a
+// fixed-size slot, found through an open-addressed table like the one
+// in SourceStats. Payloads are compared sixteen bytes (one hexdump row)
+// at a time as a pair of 64 bit words, so that identical rows cost two
+// loads and a compare.
+//
+class DeltaDump
+{
+ public:
+  DeltaDump(const HexDump *hexdump);
+  void setShowRuler(bool state);
+  void format(OutputBuffer *out,const PacketView &pkt,
+	      int64_t delta=HEXDUMP_NO_DELTA);
+  uint64_t packetsUnchanged() const;
+
+ private:
+  struct Entry {
+    uint64_t key;  // Zero when the slot is empty
+    unsigned payload;
+  };
+  struct Payload {
+    int len;
+    char data[DELTADUMP_MAX_PAYLOAD];
+  };
+  Payload *Find(uint32_t addr,uint16_t port,bool *created);
+  void Grow();
+  unsigned Compare(const char *old_data,int old_len,const char *new_data,
+		   int new_len);
+  void FormatSummary(char *str,unsigned changed,int old_len,
+		     int new_len) const;
+  const HexDump *delta_hexdump;
+  bool delta_show_ruler;
+  std::vector<Entry> delta_entries;
+  std::vector<Payload> delta_payloads;
+  unsigned delta_mask;
+  std::vector<unsigned> delta_rows;
+  unsigned delta_ranges[DELTADUMP_MAX_RANGES][2];
+  unsigned delta_range_count;
+  uint64_t delta_unchanged;
+};
+
+
+#endif  // DELTADUMP_H
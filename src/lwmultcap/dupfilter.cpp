@@ -0,0 +1,145 @@
+// dupfilter.cpp
+//
+// Duplicate packet suppression for lwmultcap(1)
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <string.h>
+
+#include "dupfilter.h"
+
+static inline uint64_t Rotate(uint64_t x,int r)
+{
+  return (x<<r)|(x>>(64-r));
+}
+
+
+static inline uint64_t Mix(uint64_t w)
+{
+  w*=0x87C37B91114253D5ull;
+  w=Rotate(w,31);
+  w*=0x4CF5AD432745937Full;
+  return w;
+}
+
+
+DupFilter::DupFilter(uint64_t window)
+{
+  dup_entries=new Entry[DUPFILTER_TABLE_SIZE];
+  memset(dup_entries,0,DUPFILTER_TABLE_SIZE*sizeof(Entry));
+  dup_window=window;
+  dup_suppressed=0;
+  dup_interval_suppressed=0;
+}
+
+
+DupFilter::~DupFilter()
+{
+  delete[] dup_entries;
+}
+
+
+bool DupFilter::isDuplicate(const PacketView &pkt)
+{
+  uint64_t h=hash(pkt.data(),pkt.size(),
+		  ((uint64_t)pkt.dstAddress()<<16)|pkt.dstPort());
+  unsigned slot;
+  Entry *free_entry=NULL;
+  Entry *oldest=NULL;
+
+  if(h==0) {
+    h=1;
+  }
+  slot=(unsigned)(h>>32)&(DUPFILTER_TABLE_SIZE-1);
+  for(unsigned i=0;i<DUPFILTER_MAX_PROBE;i++) {
+    Entry *e=dup_entries+((slot+i)&(DUPFILTER_TABLE_SIZE-1));
+    if(e->hash==0) {
+      if(free_entry==NULL) {
+	free_entry=e;
+      }
+      break;
+    }
+    if((int64_t)(pkt.timestamp()-e->timestamp)>(int64_t)dup_window) {
+      if(free_entry==NULL) {
+	free_entry=e;  // Expired, but keep looking for a live match
+      }
+      continue;
+    }
+    if(e->hash==h) {
+      dup_suppressed++;
+      dup_interval_suppressed++;
+      return true;
+    }
+    if((oldest==NULL)||(e->timestamp<oldest->timestamp)) {
+      oldest=e;
+    }
+  }
+  if(free_entry==NULL) {
+    free_entry=oldest;
+  }
+  free_entry->hash=h;
+  free_entry->timestamp=pkt.timestamp();
+
+  return false;
+}
+
+
+uint64_t DupFilter::suppressed() const
+{
+  return dup_suppressed;
+}
+
+
+uint64_t DupFilter::intervalSuppressed() const
+{
+  return dup_interval_suppressed;
+}
+
+
+void DupFilter::resetInterval()
+{
+  dup_interval_suppressed=0;
+}
+
+
+uint64_t DupFilter::hash(const char *data,int len,uint64_t seed)
+{
+  //
+  // After MurmurHash3, taking the payload eight bytes at a time
+  //
+  uint64_t h=seed^((uint64_t)len*0x9E3779B97F4A7C15ull);
+  uint64_t w;
+  int i;
+
+  for(i=0;(i+8)<=len;i+=8) {
+    memcpy(&w,data+i,8);
+    h^=Mix(w);
+    h=Rotate(h,27)*5+0x52DCE729;
+  }
+  if(i<len) {
+    w=0;
+    memcpy(&w,data+i,len-i);
+    h^=Mix(w);
+  }
+  h^=h>>33;
+  h*=0xFF51AFD7ED558CCDull;
+  h^=h>>33;
+  h*=0xC4CEB9FE1A85EC53ull;
+  h^=h>>33;
+
+  return h;
+}
@@ -0,0 +1,63 @@
+// dupfilter.h
+//
+// Duplicate packet suppression for lwmultcap(1)
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef DUPFILTER_H
+#define DUPFILTER_H
+
+#include <stdint.h>
+
+#include "packetview.h"
+
+#define DUPFILTER_TABLE_SIZE 65536  // Must be a power of two
+#define DUPFILTER_MAX_PROBE 16
+#define DUPFILTER_REPORT_INTERVAL 10000  // mS
+
+//
+// Remembers a 64 bit hash of each payload (and the group it arrived on)
+// along with when it was first seen, in a fixed-size, linearly probed
+// table. Entries older than the window are reused in place rather than
+// removed, so probe sequences stay intact without tombstones. Should a
+// probe sequence fill up, the oldest entry in it is overwritten; at worst
+// that lets a duplicate through.
+//
+class DupFilter
+{
+ public:
+  DupFilter(uint64_t window);
+  ~DupFilter();
+  bool isDuplicate(const PacketView &pkt);
+  uint64_t suppressed() const;
+  uint64_t intervalSuppressed() const;
+  void resetInterval();
+  static uint64_t hash(const char *data,int len,uint64_t seed);
+
+ private:
+  struct Entry {
+    uint64_t hash;  // Zero when the slot is empty
+    uint64_t timestamp;
+  };
+  Entry *dup_entries;
+  uint64_t dup_window;
+  uint64_t dup_suppressed;
+  uint64_t dup_interval_suppressed;
+};
+
+
+#endif  // DUPFILTER_H
@@ -0,0 +1,182 @@
+// filterbench.cpp
+//
+// Per-packet cost of lwmultcap(1) filter expressions
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+//   Usage: filterbench [<iterations>]
+//
+//   Evaluates the same filter over a mix of synthetic packets, once
+//   with QMap/QList iteration equivalent to the '--filter-*' switches
+//   and once as a compiled FilterExpr, checks that the two agree on
+//   every packet, then times each.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <QByteArray>
+#include <QList>
+#include <QMap>
+
+#include "filterexpr.h"
+
+#define BENCH_PACKETS 64
+#define BENCH_PACKET_SIZE 64
+#define BENCH_EXPRESSION "(u8[0] == 0x80 or u8[1] == 0x60) and (u32[12] == 0x41424344 or u32[16] == 0x45464748) and (src == 192.168.10.30 or src == 192.168.10.31)"
+
+QMap<unsigned,char> filter_bytes;
+QMap<unsigned,QByteArray> filter_strings;
+QList<uint32_t> filter_source_addresses;
+
+bool LegacyMatches(const PacketView &data)
+{
+  bool match=false;
+
+  for(QMap<unsigned,char>::const_iterator it=filter_bytes.begin();
+      it!=filter_bytes.end();it++) {
+    if((it.key()<(unsigned)data.size())&&(it.value()==data.at(it.key()))) {
+      match=true;
+      break;
+    }
+  }
+  if((filter_bytes.size()>0)&&(!match)) {
+    return false;
+  }
+
+  match=false;
+  for(QMap<unsigned,QByteArray>::const_iterator it=filter_strings.begin();
+      it!=filter_strings.end();it++) {
+    if(data.matches(it.key(),it.value().constData(),it.value().size())) {
+      match=true;
+      break;
+    }
+  }
+  if((filter_strings.size()>0)&&(!match)) {
+    return false;
+  }
+
+  match=false;
+  for(int i=0;i<filter_source_addresses.size();i++) {
+    if(filter_source_addresses.at(i)==data.srcAddress()) {
+      match=true;
+      break;
+    }
+  }
+  if((filter_source_addresses.size()>0)&&(!match)) {
+    return false;
+  }
+
+  return true;
+}
+
+
+double Now()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return (double)ts.tv_sec+(double)ts.tv_nsec/1000000000.0;
+}
+
+
+int main(int argc,char *argv[])
+{
+  unsigned iterations=200000;
+  char data[BENCH_PACKETS][BENCH_PACKET_SIZE];
+  PacketView pkts[BENCH_PACKETS];
+  FilterExpr expr;
+  std::string err_msg;
+  unsigned legacy_hits=0;
+  unsigned expr_hits=0;
+  double start;
+  double legacy_secs;
+  double expr_secs;
+
+  if(argc>1) {
+    iterations=strtoul(argv[1],NULL,10);
+  }
+
+  //
+  // Equivalent to '--filter-byte=0:0x80 --filter-byte=1:0x60
+  // --filter-string=12:ABCD --filter-string=16:EFGH
+  // --filter-source-address=192.168.10.30
+  // --filter-source-address=192.168.10.31'
+  //
+  filter_bytes[0]=(char)0x80;
+  filter_bytes[1]=(char)0x60;
+  filter_strings[12]="ABCD";
+  filter_strings[16]="EFGH";
+  filter_source_addresses.push_back(0xC0A80A1E);
+  filter_source_addresses.push_back(0xC0A80A1F);
+  if(!expr.compile(BENCH_EXPRESSION,&err_msg)) {
+    fprintf(stderr,"filterbench: %s\n",err_msg.c_str());
+    exit(1);
+  }
+
+  //
+  // A mix of packets that fail at each stage, and some that pass
+  //
+  for(unsigned i=0;i<BENCH_PACKETS;i++) {
+    for(unsigned j=0;j<BENCH_PACKET_SIZE;j++) {
+      data[i][j]=0xFF&(i*31+j*7);
+    }
+    data[i][0]=(i%4)==0?0x12:0x80;
+    data[i][1]=0x60;
+    memcpy(data[i]+12,(i%3)==0?"ABCX":"ABCD",4);
+    pkts[i]=PacketView(data[i],BENCH_PACKET_SIZE);
+    pkts[i].setSource(0xC0A80A1E + i%5,49152);
+  }
+  for(unsigned i=0;i<BENCH_PACKETS;i++) {
+    if(LegacyMatches(pkts[i])!=expr.matches(pkts[i])) {
+      fprintf(stderr,"filterbench: results differ for packet %u\n",i);
+      exit(1);
+    }
+  }
+
+  start=Now();
+  for(unsigned i=0;i<iterations;i++) {
+    for(unsigned j=0;j<BENCH_PACKETS;j++) {
+      legacy_hits+=LegacyMatches(pkts[j]);
+    }
+  }
+  legacy_secs=Now()-start;
+
+  start=Now();
+  for(unsigned i=0;i<iterations;i++) {
+    for(unsigned j=0;j<BENCH_PACKETS;j++) {
+      expr_hits+=expr.matches(pkts[j]);
+    }
+  }
+  expr_secs=Now()-start;
+
+  if(legacy_hits!=expr_hits) {
+    fprintf(stderr,"filterbench: hit counts differ\n");
+    exit(1);
+  }
+  printf("%s\n\n",BENCH_EXPRESSION);
+  expr.print(stdout);
+  printf("\n%u packets, %u matched\n",iterations*BENCH_PACKETS,expr_hits);
+  printf("  QMap iteration: %8.1f ns/packet\n",
+	 1e9*legacy_secs/((double)iterations*BENCH_PACKETS));
+  printf("  FilterExpr:     %8.1f ns/packet\n",
+	 1e9*expr_secs/((double)iterations*BENCH_PACKETS));
+  printf("  speedup:        %8.1fx\n",legacy_secs/expr_secs);
+
+  return 0;
+}
@@ -0,0 +1,519 @@
+// filterexpr.cpp
+//
+// Boolean packet filter expressions for lwmultcap(1)
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "filterexpr.h"
+
+static const char *filterexpr_field_names[]=
+  {"u8","u16","u32","len","src","dst","sport","dport"};
+static const uint32_t filterexpr_field_max[]=
+  {0xFF,0xFFFF,0xFFFFFFFF,0xFFFF,0xFFFFFFFF,0xFFFFFFFF,0xFFFF,0xFFFF};
+static const uint32_t filterexpr_field_size[]={1,2,4,0,0,0,0,0};
+static const char *filterexpr_op_names[]=
+  {"==","!=","<","<=",">",">=","in"};
+
+FilterExpr::FilterExpr()
+{
+  expr_pos=0;
+  expr_token_pos=0;
+}
+
+
+bool FilterExpr::compile(const std::string &expr,std::string *err_msg)
+{
+  int root;
+
+  expr_text=expr;
+  expr_pos=0;
+  expr_error.clear();
+  expr_nodes.clear();
+  expr_labels.clear();
+  expr_program.clear();
+
+  NextToken();
+  if(expr_token.empty()) {
+    *err_msg="empty filter expression";
+    return false;
+  }
+  root=ParseOr();
+  if(expr_error.empty()&&(!expr_token.empty())) {
+    Error("unexpected \""+expr_token+"\"");
+  }
+  if(!expr_error.empty()) {
+    *err_msg=expr_error;
+    return false;
+  }
+
+  //
+  // Generate, then turn the labels into instruction indices. Every
+  // label is set just before the code for some node is generated, so
+  // they all land on a real instruction.
+  //
+  Generate(root,Accept,Reject);
+  for(unsigned i=0;i<expr_program.size();i++) {
+    Insn &insn=expr_program[i];
+    if(insn.jt>=0) {
+      insn.jt=expr_labels.at(insn.jt);
+    }
+    if(insn.jf>=0) {
+      insn.jf=expr_labels.at(insn.jf);
+    }
+    if(insn.jf_bounds>=0) {
+      insn.jf_bounds=expr_labels.at(insn.jf_bounds);
+    }
+  }
+
+  return true;
+}
+
+
+void FilterExpr::print(FILE *f) const
+{
+  for(unsigned i=0;i<expr_program.size();i++) {
+    const Insn &insn=expr_program.at(i);
+    int jumps[2]={insn.jt,insn.jf};
+    char str[32];
+
+    if(insn.op==OpNe) {  // Show the targets as written
+      jumps[0]=insn.jf;
+      jumps[1]=insn.jt;
+    }
+
+    fprintf(f,"(%03u) ",i);
+    if(insn.field<=FieldU32) {
+      snprintf(str,32,"%s[%u]",filterexpr_field_names[insn.field],
+	       insn.offset);
+    }
+    else {
+      snprintf(str,32,"%s",filterexpr_field_names[insn.field]);
+    }
+    fprintf(f,"%-10s ",str);
+    if(insn.mask!=0xFFFFFFFF) {
+      fprintf(f,"& 0x%-8x ",insn.mask);
+    }
+    else {
+      fprintf(f,"%-12s","");
+    }
+    if(insn.op==OpIn) {
+      snprintf(str,32,"0x%x..0x%x",insn.k,insn.k2);
+    }
+    else {
+      snprintf(str,32,"0x%x",insn.k);
+    }
+    fprintf(f,"%-2s %-22s",filterexpr_op_names[insn.op],str);
+    for(unsigned j=0;j<2;j++) {
+      fprintf(f," %s ",j==0?"jt":"jf");
+      switch(jumps[j]) {
+      case Accept:
+	fprintf(f,"%-6s","accept");
+	break;
+
+      case Reject:
+	fprintf(f,"%-6s","reject");
+	break;
+
+      default:
+	fprintf(f,"%-6d",jumps[j]);
+	break;
+      }
+    }
+    fprintf(f,"\n");
+  }
+}
+
+
+int FilterExpr::ParseOr()
+{
+  int left=ParseAnd();
+
+  while(expr_error.empty()&&(Consume("or")||Consume("||"))) {
+    int right=ParseAnd();
+    left=NewNode(NodeOr,left,right);
+  }
+  return left;
+}
+
+
+int FilterExpr::ParseAnd()
+{
+  int left=ParseNot();
+
+  while(expr_error.empty()&&(Consume("and")||Consume("&&"))) {
+    int right=ParseNot();
+    left=NewNode(NodeAnd,left,right);
+  }
+  return left;
+}
+
+
+int FilterExpr::ParseNot()
+{
+  if(Consume("not")||Consume("!")) {
+    return NewNode(NodeNot,ParseNot());
+  }
+  return ParsePrimary();
+}
+
+
+int FilterExpr::ParsePrimary()
+{
+  int node;
+  unsigned field;
+  uint32_t offset=0;
+  Insn *cmp;
+
+  if(!expr_error.empty()) {
+    return -1;
+  }
+  if(Consume("(")) {
+    node=ParseOr();
+    if(!Consume(")")) {
+      Error("expected \")\"");
+    }
+    return node;
+  }
+
+  //
+  // Field
+  //
+  for(field=0;field<sizeof(filterexpr_field_names)/sizeof(char *);field++) {
+    if(expr_token==filterexpr_field_names[field]) {
+      break;
+    }
+  }
+  if(field==sizeof(filterexpr_field_names)/sizeof(char *)) {
+    Error("expected a field name");
+    return -1;
+  }
+  NextToken();
+  if(field<=FieldU32) {
+    if(!Consume("[")) {
+      Error("expected \"[\"");
+      return -1;
+    }
+    if(!ParseNumber(&offset)) {
+      return -1;
+    }
+    if(offset>FILTEREXPR_MAX_OFFSET) {
+      Error("offset is out of range");
+      return -1;
+    }
+    if(!Consume("]")) {
+      Error("expected \"]\"");
+      return -1;
+    }
+  }
+  node=NewNode(NodeCompare);
+  cmp=&expr_nodes[node].cmp;
+  cmp->field=field;
+  cmp->offset=offset;
+  cmp->mask=0xFFFFFFFF;
+
+  //
+  // Optional Mask
+  //
+  if(Consume("&")) {
+    if(!ParseNumber(&cmp->mask)) {
+      return -1;
+    }
+  }
+
+  //
+  // Comparison
+  //
+  for(cmp->op=0;cmp->op<sizeof(filterexpr_op_names)/sizeof(char *);
+      cmp->op++) {
+    if(expr_token==filterexpr_op_names[cmp->op]) {
+      break;
+    }
+  }
+  if(cmp->op==sizeof(filterexpr_op_names)/sizeof(char *)) {
+    Error("expected a comparison operator");
+    return -1;
+  }
+  NextToken();
+  if(!ParseValue(field,&cmp->k)) {
+    return -1;
+  }
+  cmp->k2=cmp->k;
+  if(cmp->op==OpIn) {
+    if(!Consume("..")) {
+      Error("expected \"..\"");
+      return -1;
+    }
+    if(!ParseValue(field,&cmp->k2)) {
+      return -1;
+    }
+    if(cmp->k2<cmp->k) {
+      Error("range is backwards");
+      return -1;
+    }
+  }
+
+  return node;
+}
+
+
+bool FilterExpr::ParseNumber(uint32_t *val)
+{
+  char *end=NULL;
+  unsigned long n;
+
+  if(expr_token.empty()||(!isdigit(expr_token.at(0)))) {
+    Error("expected a number");
+    return false;
+  }
+  n=strtoul(expr_token.c_str(),&end,0);
+  if((*end!=0)||(n>0xFFFFFFFF)) {
+    Error("invalid number \""+expr_token+"\"");
+    return false;
+  }
+  *val=n;
+  NextToken();
+
+  return true;
+}
+
+
+bool FilterExpr::ParseValue(uint8_t field,uint32_t *val)
+{
+  unsigned quad[4];
+  char junk;
+
+  //
+  // Addresses may also be given in dotted-quad form
+  //
+  if(((field==FieldSrc)||(field==FieldDst))&&
+     (sscanf(expr_token.c_str(),"%u.%u.%u.%u%c",
+	     quad,quad+1,quad+2,quad+3,&junk)==4)) {
+    if((quad[0]>255)||(quad[1]>255)||(quad[2]>255)||(quad[3]>255)) {
+      Error("invalid address \""+expr_token+"\"");
+      return false;
+    }
+    *val=(quad[0]<<24)|(quad[1]<<16)|(quad[2]<<8)|quad[3];
+    NextToken();
+    return true;
+  }
+  if(!ParseNumber(val)) {
+    return false;
+  }
+  if(*val>filterexpr_field_max[field]) {
+    Error(std::string("value too large for \"")+
+	  filterexpr_field_names[field]+"\"");
+    return false;
+  }
+  return true;
+}
+
+
+void FilterExpr::NextToken()
+{
+  static const char *pairs[]={"==","!=","<=",">=","&&","||","..",NULL};
+  const char *p;
+
+  while((expr_pos<expr_text.size())&&isspace(expr_text.at(expr_pos))) {
+    expr_pos++;
+  }
+  expr_token_pos=expr_pos;
+  expr_token.clear();
+  if(expr_pos>=expr_text.size()) {
+    return;
+  }
+  p=expr_text.c_str()+expr_pos;
+
+  //
+  // Words
+  //
+  if(isalpha(*p)||(*p=='_')) {
+    while(isalnum(*p)||(*p=='_')) {
+      expr_token+=*p++;
+    }
+    expr_pos+=expr_token.size();
+    return;
+  }
+
+  //
+  // Numbers and dotted quads, taking care not to eat a following ".."
+  //
+  if(isdigit(*p)) {
+    while(isalnum(*p)) {
+      expr_token+=*p++;
+    }
+    while((p[0]=='.')&&isdigit(p[1])) {
+      expr_token+=*p++;
+      while(isdigit(*p)) {
+	expr_token+=*p++;
+      }
+    }
+    expr_pos+=expr_token.size();
+    return;
+  }
+
+  //
+  // Punctuation
+  //
+  for(unsigned i=0;pairs[i]!=NULL;i++) {
+    if((p[0]==pairs[i][0])&&(p[1]==pairs[i][1])) {
+      expr_token=pairs[i];
+      expr_pos+=2;
+      return;
+    }
+  }
+  expr_token=*p;
+  expr_pos++;
+}
+
+
+bool FilterExpr::Consume(const char *tok)
+{
+  if(expr_token==tok) {
+    NextToken();
+    return true;
+  }
+  return false;
+}
+
+
+void FilterExpr::Error(const std::string &msg)
+{
+  char str[64];
+
+  if(expr_error.empty()) {
+    snprintf(str,64," at column %u",expr_token_pos+1);
+    expr_error=msg+str;
+  }
+}
+
+
+int FilterExpr::NewNode(NodeType type,int left,int right)
+{
+  Node node;
+
+  memset(&node,0,sizeof(node));
+  node.type=type;
+  node.left=left;
+  node.right=right;
+  expr_nodes.push_back(node);
+
+  return expr_nodes.size()-1;
+}
+
+
+void FilterExpr::Generate(int node,int jt_label,int jf_label)
+{
+  const Node &n=expr_nodes.at(node);
+  int next;
+
+  switch(n.type) {
+  case NodeCompare:
+    expr_program.push_back(n.cmp);
+    Lower(&expr_program.back(),jt_label,jf_label);
+    break;
+
+  case NodeAnd:
+    next=NewLabel();
+    Generate(n.left,next,jf_label);
+    SetLabel(next);
+    Generate(n.right,jt_label,jf_label);
+    break;
+
+  case NodeOr:
+    next=NewLabel();
+    Generate(n.left,jt_label,next);
+    SetLabel(next);
+    Generate(n.right,jt_label,jf_label);
+    break;
+
+  case NodeNot:
+    Generate(n.left,jf_label,jt_label);
+    break;
+  }
+}
+
+
+void FilterExpr::Lower(Insn *insn,int jt_label,int jf_label) const
+{
+  uint32_t lo=insn->k;
+  uint32_t hi=insn->k;
+  bool negate=false;
+  bool never=false;
+
+  switch(insn->op) {
+  case OpEq:
+    break;
+
+  case OpNe:
+    negate=true;
+    break;
+
+  case OpLt:
+    never=insn->k==0;
+    lo=0;
+    hi=insn->k-1;
+    break;
+
+  case OpLe:
+    lo=0;
+    break;
+
+  case OpGt:
+    never=insn->k==0xFFFFFFFF;
+    lo=insn->k+1;
+    hi=0xFFFFFFFF;
+    break;
+
+  case OpGe:
+    hi=0xFFFFFFFF;
+    break;
+
+  case OpIn:
+    hi=insn->k2;
+    break;
+  }
+  insn->need=insn->offset+filterexpr_field_size[insn->field];
+  insn->lo=lo;
+  insn->span=hi-lo;
+  insn->jt=jt_label;
+  insn->jf=jf_label;
+  insn->jf_bounds=jf_label;
+  if(negate) {
+    insn->jt=jf_label;
+    insn->jf=jt_label;
+  }
+  if(never) {
+    insn->jt=jf_label;
+  }
+}
+
+
+int FilterExpr::NewLabel()
+{
+  expr_labels.push_back(-1);
+  return expr_labels.size()-1;
+}
+
+
+void FilterExpr::SetLabel(int label)
+{
+  expr_labels[label]=expr_program.size();
+}
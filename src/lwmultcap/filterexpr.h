@@ -0,0 +1,151 @@
+// filterexpr.h
+//
+// Boolean packet filter expressions for lwmultcap(1)
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef FILTEREXPR_H
+#define FILTEREXPR_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "packetview.h"
+
+#define FILTEREXPR_MAX_OFFSET 65535
+
+//
+// An expression such as
+//
+//   (u8[0] & 0xF0 == 0x80 or u16[2] in 1000..1999) and not len < 12
+//
+// is parsed once into a list of compare-and-branch instructions, each
+// of which jumps forward to another instruction or to a final verdict.
+// AND, OR and NOT cost nothing at run time; evaluation is a single pass
+// over at most one instruction per comparison in the expression. Every
+// comparison is reduced to an unsigned range test, with '!=' and the
+// like handled by swapping the branch targets.
+//
+class FilterExpr
+{
+ public:
+  FilterExpr();
+  bool compile(const std::string &expr,std::string *err_msg);
+  bool matches(const PacketView &pkt) const
+  {
+    int pc=0;
+    uint32_t val=0;
+
+    while(pc>=0) {
+      const Insn &insn=expr_program[pc];
+      if(insn.need>(unsigned)pkt.size()) {
+	pc=insn.jf_bounds;
+	continue;
+      }
+      val=Load(insn,pkt)&insn.mask;
+      pc=((val-insn.lo)<=insn.span)?insn.jt:insn.jf;
+    }
+    return pc==Accept;
+  }
+  void print(FILE *f) const;
+
+ private:
+  enum Verdict {Accept=-1,Reject=-2};
+  enum Field {FieldU8=0,FieldU16=1,FieldU32=2,FieldLen=3,FieldSrc=4,
+	      FieldDst=5,FieldSrcPort=6,FieldDstPort=7};
+  enum Op {OpEq=0,OpNe=1,OpLt=2,OpLe=3,OpGt=4,OpGe=5,OpIn=6};
+  enum NodeType {NodeCompare=0,NodeAnd=1,NodeOr=2,NodeNot=3};
+  struct Insn {
+    uint8_t field;
+    uint8_t op;
+    uint32_t offset;
+    uint32_t need;  // Bytes of payload needed to load the field
+    uint32_t mask;
+    uint32_t k;
+    uint32_t k2;
+    uint32_t lo;
+    uint32_t span;
+    int jt;
+    int jf;
+    int jf_bounds;  // Where to go if the packet is too short
+  };
+  struct Node {
+    NodeType type;
+    int left;
+    int right;
+    Insn cmp;
+  };
+  static uint32_t Load(const Insn &insn,const PacketView &pkt)
+  {
+    const uint8_t *p=(const uint8_t *)pkt.data()+insn.offset;
+
+    switch(insn.field) {
+    case FieldU8:
+      return p[0];
+
+    case FieldU16:
+      return (p[0]<<8)|p[1];
+
+    case FieldU32:
+      return ((uint32_t)p[0]<<24)|(p[1]<<16)|(p[2]<<8)|p[3];
+
+    case FieldLen:
+      return pkt.size();
+
+    case FieldSrc:
+      return pkt.srcAddress();
+
+    case FieldDst:
+      return pkt.dstAddress();
+
+    case FieldSrcPort:
+      return pkt.srcPort();
+
+    case FieldDstPort:
+      return pkt.dstPort();
+    }
+    return 0;
+  }
+  int ParseOr();
+  int ParseAnd();
+  int ParseNot();
+  int ParsePrimary();
+  bool ParseNumber(uint32_t *val);
+  bool ParseValue(uint8_t field,uint32_t *val);
+  void NextToken();
+  bool Consume(const char *tok);
+  void Error(const std::string &msg);
+  int NewNode(NodeType type,int left=-1,int right=-1);
+  void Generate(int node,int jt_label,int jf_label);
+  void Lower(Insn *insn,int jt_label,int jf_label) const;
+  int NewLabel();
+  void SetLabel(int label);
+  std::string expr_text;
+  unsigned expr_pos;
+  std::string expr_token;
+  unsigned expr_token_pos;
+  std::string expr_error;
+  std::vector<Node> expr_nodes;
+  std::vector<int> expr_labels;
+  std::vector<Insn> expr_program;
+};
+
+
+#endif  // FILTEREXPR_H
@@ -0,0 +1,131 @@
+// flightrecorder.cpp
+//
+// Ring buffers of recent packets for lwmultcap(1)
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "flightrecorder.h"
+
+FlightRecorder::FlightRecorder(unsigned rings,unsigned packets,
+			       unsigned slot_size)
+{
+  rec_ring_quan=rings;
+  rec_packets=packets;
+  rec_slot_size=slot_size;
+  rec_slots=new Slot[rings*packets];
+  rec_data=new char[(size_t)rings*packets*slot_size];
+  rec_rings=new Ring[rings];
+  rec_max_age=0;
+  clear();
+}
+
+
+FlightRecorder::~FlightRecorder()
+{
+  delete[] rec_rings;
+  delete[] rec_data;
+  delete[] rec_slots;
+}
+
+
+//
+// Zero for no limit beyond the size of the rings
+//
+void FlightRecorder::setMaxAge(uint64_t nsecs)
+{
+  rec_max_age=nsecs;
+}
+
+
+void FlightRecorder::record(const PacketView &pkt)
+{
+  unsigned r=pkt.group()%rec_ring_quan;
+  Ring *ring=rec_rings+r;
+  unsigned n=r*rec_packets+ring->next;
+  Slot *slot=rec_slots+n;
+  unsigned size=pkt.size();
+
+  if(size>rec_slot_size) {
+    size=rec_slot_size;
+  }
+  slot->timestamp=pkt.timestamp();
+  slot->src_addr=pkt.srcAddress();
+  slot->dst_addr=pkt.dstAddress();
+  slot->src_port=pkt.srcPort();
+  slot->dst_port=pkt.dstPort();
+  slot->size=size;
+  memcpy(rec_data+(size_t)n*rec_slot_size,pkt.data(),size);
+  if(++ring->next==rec_packets) {
+    ring->next=0;
+  }
+  if(ring->count<rec_packets) {
+    ring->count++;
+  }
+  if(pkt.timestamp()>rec_newest) {
+    rec_newest=pkt.timestamp();
+  }
+}
+
+
+//
+// Views of everything recorded, oldest first, merging the groups by
+// timestamp. They point into the rings, so are good only until the next
+// call to record().
+//
+void FlightRecorder::collect(std::vector<PacketView> *pkts) const
+{
+  pkts->clear();
+  for(unsigned r=0;r<rec_ring_quan;r++) {
+    const Ring *ring=rec_rings+r;
+    unsigned i=(ring->next+rec_packets-ring->count)%rec_packets;
+    for(unsigned j=0;j<ring->count;j++) {
+      unsigned n=r*rec_packets+i;
+      const Slot *slot=rec_slots+n;
+      if((rec_max_age==0)||((slot->timestamp+rec_max_age)>=rec_newest)) {
+	PacketView pkt(rec_data+(size_t)n*rec_slot_size,slot->size);
+	pkt.setSource(slot->src_addr,slot->src_port);
+	pkt.setDestination(slot->dst_addr,slot->dst_port);
+	pkt.setTimestamp(slot->timestamp);
+	pkt.setGroup(r);
+	pkts->push_back(pkt);
+      }
+      if(++i==rec_packets) {
+	i=0;
+      }
+    }
+  }
+  if(rec_ring_quan>1) {
+    std::stable_sort(pkts->begin(),pkts->end(),
+		     [](const PacketView &a,const PacketView &b) {
+		       return a.timestamp()<b.timestamp();
+		     });
+  }
+}
+
+
+void FlightRecorder::clear()
+{
+  for(unsigned i=0;i<rec_ring_quan;i++) {
+    rec_rings[i].next=0;
+    rec_rings[i].count=0;
+  }
+  rec_newest=0;
+}
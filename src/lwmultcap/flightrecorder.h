@@ -0,0 +1,73 @@
+// flightrecorder.h
+//
+// Ring buffers of recent packets for lwmultcap(1)
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef FLIGHTRECORDER_H
+#define FLIGHTRECORDER_H
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "packetview.h"
+
+#define FLIGHTRECORDER_DEFAULT_PACKETS 1000  // Per group
+#define FLIGHTRECORDER_DEFAULT_POST_TRIGGER 100
+
+//
+// One ring of fixed-size slots for each group, all allocated up front,
+// so recording a packet is a copy into the next slot and nothing more.
+// Once a ring is full its oldest packet is overwritten. Payloads longer
+// than a slot are truncated.
+//
+class FlightRecorder
+{
+ public:
+  FlightRecorder(unsigned rings,unsigned packets,unsigned slot_size);
+  ~FlightRecorder();
+  void setMaxAge(uint64_t nsecs);
+  void record(const PacketView &pkt);
+  void collect(std::vector<PacketView> *pkts) const;
+  void clear();
+
+ private:
+  struct Slot {
+    uint64_t timestamp;
+    uint32_t src_addr;
+    uint32_t dst_addr;
+    uint16_t src_port;
+    uint16_t dst_port;
+    uint16_t size;
+  };
+  struct Ring {
+    unsigned next;
+    unsigned count;
+  };
+  Slot *rec_slots;
+  char *rec_data;
+  Ring *rec_rings;
+  unsigned rec_ring_quan;
+  unsigned rec_packets;
+  unsigned rec_slot_size;
+  uint64_t rec_max_age;
+  uint64_t rec_newest;
+};
+
+
+#endif  // FLIGHTRECORDER_H
@@ -0,0 +1,239 @@
+// formatpool.cpp
+//
+// Format packets for output on a pool of threads for lwmultcap(1)
+//
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <string.h>
+
+#include <QMutexLocker>
+
+#include "formatpool.h"
+
+FormatPoolThread::FormatPoolThread(FormatPool *pool,bool writer)
+  : QThread()
+{
+  thread_pool=pool;
+  thread_writer=writer;
+}
+
+
+void FormatPoolThread::run()
+{
+  if(thread_writer) {
+    thread_pool->WriteLoop();
+  }
+  else {
+    thread_pool->WorkLoop();
+  }
+}
+
+
+FormatPool::FormatPool(unsigned workers,int fd,Formatter formatter)
+{
+  pool_formatter=formatter;
+  pool_fd=fd;
+  pool_job=NULL;
+  pool_submitted=0;
+  pool_taken=0;
+  pool_written=0;
+  pool_exiting=false;
+  pool_write_error=false;
+  for(unsigned i=0;i<FORMATPOOL_JOB_COUNT;i++) {
+    pool_jobs[i].pkts.reserve(FORMATPOOL_JOB_PACKETS);
+    pool_jobs[i].data.resize(FORMATPOOL_JOB_DATA_SIZE);
+    pool_jobs[i].used=0;
+    pool_jobs[i].out=new OutputBuffer(FORMATPOOL_JOB_DATA_SIZE);
+    pool_jobs[i].done=false;
+  }
+  pool_threads.push_back(new FormatPoolThread(this,true));
+  for(unsigned i=0;i<workers;i++) {
+    pool_threads.push_back(new FormatPoolThread(this,false));
+  }
+  for(unsigned i=0;i<pool_threads.size();i++) {
+    pool_threads.at(i)->start();
+  }
+}
+
+
+FormatPool::~FormatPool()
+{
+  finish();
+  for(unsigned i=0;i<pool_threads.size();i++) {
+    delete pool_threads.at(i);
+  }
+  for(unsigned i=0;i<FORMATPOOL_JOB_COUNT;i++) {
+    delete pool_jobs[i].out;
+  }
+}
+
+
+void FormatPool::submit(const PacketView &pkt)
+{
+  PacketView view;
+
+  //
+  // Wait for the next job in the ring to be written out and free
+  //
+  if(pool_job==NULL) {
+    QMutexLocker locker(&pool_mutex);
+    while((pool_submitted-pool_written)==FORMATPOOL_JOB_COUNT) {
+      pool_free_wait.wait(&pool_mutex);
+    }
+    pool_job=pool_jobs+(pool_submitted%FORMATPOOL_JOB_COUNT);
+    pool_job->pkts.clear();
+    pool_job->used=0;
+  }
+
+  //
+  // The buffer is only ever grown while the job is empty, so the views
+  // stay good
+  //
+  if((pool_job->used+pkt.size())>pool_job->data.size()) {
+    if(!pool_job->pkts.empty()) {
+      HandOff();
+      submit(pkt);
+      return;
+    }
+    pool_job->data.resize(pkt.size());
+  }
+  memcpy(pool_job->data.data()+pool_job->used,pkt.data(),pkt.size());
+  view=PacketView(pool_job->data.data()+pool_job->used,pkt.size());
+  view.setSource(pkt.srcAddress(),pkt.srcPort());
+  view.setDestination(pkt.dstAddress(),pkt.dstPort());
+  view.setTimestamp(pkt.timestamp());
+  view.setGroup(pkt.group());
+  pool_job->pkts.push_back(view);
+  pool_job->used+=pkt.size();
+  if(pool_job->pkts.size()==FORMATPOOL_JOB_PACKETS) {
+    HandOff();
+  }
+}
+
+
+//
+// Hand off any partly filled job, so that nothing is held back
+// waiting for more packets
+//
+void FormatPool::flush()
+{
+  if(pool_job!=NULL) {
+    HandOff();
+  }
+}
+
+
+//
+// Write out everything submitted and stop the threads
+//
+void FormatPool::finish()
+{
+  flush();
+  pool_mutex.lock();
+  if(pool_exiting) {
+    pool_mutex.unlock();
+    return;
+  }
+  pool_exiting=true;
+  pool_work_wait.wakeAll();
+  pool_done_wait.wakeAll();
+  pool_mutex.unlock();
+  for(unsigned i=0;i<pool_threads.size();i++) {
+    pool_threads.at(i)->wait();
+  }
+}
+
+
+uint64_t FormatPool::jobsWritten() const
+{
+  return pool_written;
+}
+
+
+bool FormatPool::writeError() const
+{
+  return pool_write_error;
+}
+
+
+void FormatPool::HandOff()
+{
+  QMutexLocker locker(&pool_mutex);
+
+  pool_job=NULL;
+  pool_submitted++;
+  pool_work_wait.wakeOne();
+}
+
+
+void FormatPool::WorkLoop()
+{
+  Job *job;
+
+  pool_mutex.lock();
+  while(true) {
+    while((pool_taken==pool_submitted)&&(!pool_exiting)) {
+      pool_work_wait.wait(&pool_mutex);
+    }
+    if(pool_taken==pool_submitted) {
+      break;
+    }
+    job=pool_jobs+(pool_taken++%FORMATPOOL_JOB_COUNT);
+    pool_mutex.unlock();
+
+    job->out->clear();
+    for(unsigned i=0;i<job->pkts.size();i++) {
+      pool_formatter(job->out,job->pkts.at(i));
+    }
+
+    pool_mutex.lock();
+    job->done=true;
+    if(job==(pool_jobs+(pool_written%FORMATPOOL_JOB_COUNT))) {
+      pool_done_wait.wakeOne();
+    }
+  }
+  pool_mutex.unlock();
+}
+
+
+void FormatPool::WriteLoop()
+{
+  Job *job;
+
+  pool_mutex.lock();
+  while(true) {
+    job=pool_jobs+(pool_written%FORMATPOOL_JOB_COUNT);
+    while((pool_written<pool_submitted)?(!job->done):(!pool_exiting)) {
+      pool_done_wait.wait(&pool_mutex);
+    }
+    if(pool_written==pool_submitted) {
+      break;
+    }
+    pool_mutex.unlock();
+
+    if((!pool_write_error)&&(!job->out->flush(pool_fd))) {
+      pool_write_error=true;
+    }
+
+    pool_mutex.lock();
+    job->done=false;
+    pool_written++;
+    pool_free_wait.wakeOne();
+  }
+  pool_mutex.unlock();
+}
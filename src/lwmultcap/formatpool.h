@@ -0,0 +1,111 @@
+// formatpool.h
+//
+// Format packets for output on a pool of threads for lwmultcap(1)
+//
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef FORMATPOOL_H
+#define FORMATPOOL_H
+
+#include <stdint.h>
+
+#include <functional>
+#include <vector>
+
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+
+#include "outputbuffer.h"
+#include "packetview.h"
+
+#define FORMATPOOL_MAX_WORKERS 16
+#define FORMATPOOL_JOB_COUNT 64
+#define FORMATPOOL_JOB_PACKETS 64
+#define FORMATPOOL_JOB_DATA_SIZE 98304  // Bytes, grown if need be
+
+class FormatPool;
+
+class FormatPoolThread : public QThread
+{
+ public:
+  FormatPoolThread(FormatPool *pool,bool writer);
+
+ protected:
+  void run();
+
+ private:
+  FormatPool *thread_pool;
+  bool thread_writer;
+};
+
+
+//
+// Packets are copied, on the receive thread, into jobs of up to
+// FORMATPOOL_JOB_PACKETS each. Every job is tagged with a sequence
+// number as it is handed off; the workers format whole jobs into the
+// job's own text buffer in whatever order they get to them, and the
+// writer thread writes the buffers out strictly in sequence. Jobs live
+// in a fixed ring and are recycled once written, so submit() waits only
+// when the ring is full, i.e. when the output cannot keep up.
+//
+// The formatter is called on the worker threads, so must not touch
+// anything that is not safe to share.
+//
+class FormatPool
+{
+ public:
+  typedef std::function<void(OutputBuffer *,const PacketView &)> Formatter;
+  FormatPool(unsigned workers,int fd,Formatter formatter);
+  ~FormatPool();
+  void submit(const PacketView &pkt);
+  void flush();
+  void finish();
+  uint64_t jobsWritten() const;
+  bool writeError() const;
+
+ private:
+  struct Job {
+    std::vector<PacketView> pkts;  // Pointing into 'data'
+    std::vector<char> data;
+    unsigned used;
+    OutputBuffer *out;
+    bool done;
+  };
+  void HandOff();
+  void WorkLoop();
+  void WriteLoop();
+  Job pool_jobs[FORMATPOOL_JOB_COUNT];
+  Job *pool_job;  // Being filled by submit(), if any
+  std::vector<FormatPoolThread *> pool_threads;
+  Formatter pool_formatter;
+  int pool_fd;
+  uint64_t pool_submitted;
+  uint64_t pool_taken;
+  uint64_t pool_written;
+  QMutex pool_mutex;
+  QWaitCondition pool_work_wait;
+  QWaitCondition pool_done_wait;
+  QWaitCondition pool_free_wait;
+  bool pool_exiting;
+  bool pool_write_error;
+  friend class FormatPoolThread;
+};
+
+
+#endif  // FORMATPOOL_H
@@ -0,0 +1,116 @@
+// gpiodecoder.cpp
+//
+// Print Livewire GPIO events for lwmultcap(1)
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <string.h>
+#include <time.h>
+
+#include "gpiodecoder.h"
+#include "hexdump.h"
+
+GpioDecoder::GpioDecoder()
+{
+  gpio_json=false;
+  gpio_transitions_only=false;
+  gpio_states=new uint8_t[LWGPIO_MAX_PORTS];
+  gpio_known=new uint8_t[LWGPIO_MAX_PORTS];
+  memset(gpio_states,0,LWGPIO_MAX_PORTS);
+  memset(gpio_known,0,LWGPIO_MAX_PORTS);
+  gpio_skipped=0;
+}
+
+
+GpioDecoder::~GpioDecoder()
+{
+  delete[] gpio_states;
+  delete[] gpio_known;
+}
+
+
+void GpioDecoder::setJson(bool state)
+{
+  gpio_json=state;
+}
+
+
+void GpioDecoder::setTransitionsOnly(bool state)
+{
+  gpio_transitions_only=state;
+}
+
+
+void GpioDecoder::decode(OutputBuffer *out,const PacketView &pkt)
+{
+  LwGpioParser parser(pkt.data(),pkt.size());
+  LwGpioRecord rec;
+  uint8_t report;
+
+  if(!parser.isGpio()) {
+    gpio_skipped++;
+    return;
+  }
+  while(parser.nextRecord(&rec)) {
+    report=rec.mask;
+    if(gpio_transitions_only) {
+      //
+      // Pins seen before and unchanged since
+      //
+      report&=~(gpio_known[rec.port]&~(gpio_states[rec.port]^rec.states));
+    }
+    gpio_states[rec.port]=
+      (gpio_states[rec.port]&~rec.mask)|(rec.states&rec.mask);
+    gpio_known[rec.port]|=rec.mask;
+    for(unsigned i=0;i<LWGPIO_PINS;i++) {
+      if((report&(1<<i))!=0) {
+	PrintEvent(out,pkt,rec.port,i+1,(rec.states&(1<<i))!=0);
+      }
+    }
+  }
+}
+
+
+uint64_t GpioDecoder::packetsSkipped() const
+{
+  return gpio_skipped;
+}
+
+
+void GpioDecoder::PrintEvent(OutputBuffer *out,const PacketView &pkt,
+			     uint16_t port,unsigned pin,bool low)
+{
+  char src_str[16];
+  struct tm tm;
+  time_t secs=pkt.timestamp()/1000000000;
+
+  HexDump::formatAddress(src_str,pkt.srcAddress());
+  if(gpio_json) {
+    out->appendf("{\"time\":%lu.%09lu,\"source\":\"%s\",\"port\":%u,"
+		 "\"pin\":%u,\"state\":\"%s\"}\n",
+		 (unsigned long)secs,
+		 (unsigned long)(pkt.timestamp()%1000000000),
+		 src_str,port,pin,low?"low":"high");
+  }
+  else {
+    localtime_r(&secs,&tm);
+    out->appendf("%02d:%02d:%02d.%03u  %-15s  port %5u  pin %u  %s\n",
+		 tm.tm_hour,tm.tm_min,tm.tm_sec,
+		 (unsigned)((pkt.timestamp()/1000000)%1000),
+		 src_str,port,pin,low?"low":"high");
+  }
+}
@@ -0,0 +1,56 @@
+// gpiodecoder.h
+//
+// Print Livewire GPIO events for lwmultcap(1)
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef GPIODECODER_H
+#define GPIODECODER_H
+
+#include <stdint.h>
+
+#include "lwgpioparser.h"
+#include "outputbuffer.h"
+#include "packetview.h"
+
+//
+// The last known state of every port is kept in flat arrays indexed by
+// port number, so that each record costs the same no matter how many
+// ports are active.
+//
+class GpioDecoder
+{
+ public:
+  GpioDecoder();
+  ~GpioDecoder();
+  void setJson(bool state);
+  void setTransitionsOnly(bool state);
+  void decode(OutputBuffer *out,const PacketView &pkt);
+  uint64_t packetsSkipped() const;
+
+ private:
+  void PrintEvent(OutputBuffer *out,const PacketView &pkt,uint16_t port,
+		  unsigned pin,bool low);
+  bool gpio_json;
+  bool gpio_transitions_only;
+  uint8_t *gpio_states;
+  uint8_t *gpio_known;
+  uint64_t gpio_skipped;
+};
+
+
+#endif  // GPIODECODER_H
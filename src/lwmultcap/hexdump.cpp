@@ -0,0 +1,238 @@
+// hexdump.cpp
+//
+// Table-driven hexdump formatter for lwmultcap(1)
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "hexdump.h"
+
+#define HEXDUMP_RULE "------------------------------------------------------------------------------\n"
+#define HEXDUMP_TITLES "| Offset  0- 1- 2- 3- 4- 5- 6- 7- 8- 9- A- B- C- D- E- F- | 0123456789ABCDEF |\n"
+#define HEXDUMP_TITLE_RULE "----------------------------------------------------------|------------------|\n"
+
+static const char hexdump_digits[]="0123456789ABCDEF";
+
+HexDump::HexDump()
+{
+  dump_show_ruler=true;
+  dump_show_time=false;
+  for(unsigned i=0;i<256;i++) {
+    dump_hex[i][0]=hexdump_digits[i>>4];
+    dump_hex[i][1]=hexdump_digits[i&0x0F];
+    dump_hex[i][2]=' ';
+    if((i>=' ')&&(i<='~')) {
+      dump_ascii[i]=i;
+    }
+    else {
+      dump_ascii[i]='.';
+    }
+  }
+}
+
+
+void HexDump::setShowRuler(bool state)
+{
+  dump_show_ruler=state;
+}
+
+
+void HexDump::setShowTime(bool state)
+{
+  dump_show_time=state;
+}
+
+
+void HexDump::formatPacket(OutputBuffer *out,
+			   uint32_t dst_addr,uint16_t dst_port,
+			   uint32_t src_addr,uint16_t src_port,
+			   const char *data,int len,uint64_t timestamp,
+			   int64_t delta) const
+{
+  if(dump_show_ruler) {
+    formatHeader(out,dst_addr,dst_port,src_addr,src_port,len,timestamp,
+		 delta);
+  }
+  formatRows(out,data,len);
+  if(dump_show_ruler) {
+    formatFooter(out);
+  }
+}
+
+
+void HexDump::formatHeader(OutputBuffer *out,
+			   uint32_t dst_addr,uint16_t dst_port,
+			   uint32_t src_addr,uint16_t src_port,int len,
+			   uint64_t timestamp,int64_t delta) const
+{
+  char dst_str[24];
+  char src_str[24];
+  char size_str[16];
+  char time_str[40];
+  char delta_str[24];
+
+  formatAddress(dst_str,dst_addr,dst_port);
+  formatAddress(src_str,src_addr,src_port);
+  snprintf(size_str,16,"0x%04X",len);
+  out->append(HEXDUMP_RULE,sizeof(HEXDUMP_RULE)-1);
+  out->appendf("| To: %-21s    From: %-21s     size: %-7s |\n",
+	       dst_str,src_str,size_str);
+  if(dump_show_time) {
+    formatTime(time_str,timestamp);
+    formatDelta(delta_str,delta);
+    out->appendf("| Time: %-29s  Delta: %-30s |\n",time_str,delta_str);
+  }
+  out->append(HEXDUMP_RULE,sizeof(HEXDUMP_RULE)-1);
+  out->append(HEXDUMP_TITLES,sizeof(HEXDUMP_TITLES)-1);
+  out->append(HEXDUMP_TITLE_RULE,sizeof(HEXDUMP_TITLE_RULE)-1);
+}
+
+
+void HexDump::formatRows(OutputBuffer *out,const char *data,int len) const
+{
+  const uint8_t *bytes=(const uint8_t *)data;
+  char *row;
+  char *end;
+
+  //
+  // Render all rows in place; offsets wider than four digits make for
+  // longer rows, so allow a little slack
+  //
+  row=out->reserve(((len+15)/16)*(HEXDUMP_ROW_SIZE+8));
+  end=row;
+  for(int i=0;i<len;i+=16) {
+    end=FormatRow(end,i,bytes+i,len-i);
+  }
+  out->commit(end-row);
+}
+
+
+//
+// Render just the row starting at 'offset', which should be a multiple
+// of 16
+//
+void HexDump::formatRow(OutputBuffer *out,const char *data,int len,
+			unsigned offset) const
+{
+  char *row=out->reserve(HEXDUMP_ROW_SIZE+8);
+
+  out->commit(FormatRow(row,offset,(const uint8_t *)data+offset,
+			len-offset)-row);
+}
+
+
+void HexDump::formatFooter(OutputBuffer *out) const
+{
+  out->append(HEXDUMP_RULE,sizeof(HEXDUMP_RULE)-1);
+}
+
+
+unsigned HexDump::formatAddress(char *str,uint32_t addr)
+{
+  return sprintf(str,"%u.%u.%u.%u",0xFF&(addr>>24),0xFF&(addr>>16),
+		 0xFF&(addr>>8),0xFF&addr);
+}
+
+
+unsigned HexDump::formatAddress(char *str,uint32_t addr,uint16_t port)
+{
+  return sprintf(str,"%u.%u.%u.%u:%u",0xFF&(addr>>24),0xFF&(addr>>16),
+		 0xFF&(addr>>8),0xFF&addr,0xFFFF&port);
+}
+
+
+char *HexDump::FormatRow(char *row,unsigned offset,const uint8_t *data,
+			 int len) const
+{
+  char *ascii;
+
+  //
+  // Offset
+  //
+  if(offset<=0xFFFF) {
+    row[0]='|';
+    row[1]=' ';
+    row[2]='0';
+    row[3]='x';
+    row[4]=hexdump_digits[0x0F&(offset>>12)];
+    row[5]=hexdump_digits[0x0F&(offset>>8)];
+    row[6]=hexdump_digits[0x0F&(offset>>4)];
+    row[7]=hexdump_digits[0x0F&offset];
+    row[8]=':';
+    row[9]=' ';
+    row+=10;
+  }
+  else {
+    row+=sprintf(row,"| 0x%04X: ",offset);
+  }
+
+  //
+  // Hex and ASCII columns
+  //
+  ascii=row+50;
+  if(len>=16) {
+    for(int i=0;i<16;i++) {
+      memcpy(row+3*i,dump_hex[data[i]],3);
+      ascii[i]=dump_ascii[data[i]];
+    }
+  }
+  else {
+    for(int i=0;i<len;i++) {
+      memcpy(row+3*i,dump_hex[data[i]],3);
+      ascii[i]=dump_ascii[data[i]];
+    }
+    memset(row+3*len,' ',3*(16-len));
+    memset(ascii+len,' ',16-len);
+  }
+  row[48]='|';
+  row[49]=' ';
+  ascii[16]=' ';
+  ascii[17]='|';
+  ascii[18]='\n';
+
+  return ascii+19;
+}
+
+
+unsigned HexDump::formatTime(char *str,uint64_t timestamp)
+{
+  struct tm tm;
+  time_t secs=timestamp/1000000000;
+
+  localtime_r(&secs,&tm);
+  return sprintf(str,"%04d-%02d-%02d %02d:%02d:%02d.%09u",
+		 tm.tm_year+1900,tm.tm_mon+1,tm.tm_mday,
+		 tm.tm_hour,tm.tm_min,tm.tm_sec,
+		 (unsigned)(timestamp%1000000000));
+}
+
+
+unsigned HexDump::formatDelta(char *str,int64_t delta)
+{
+  uint64_t mag;
+
+  if(delta==HEXDUMP_NO_DELTA) {
+    return sprintf(str,"-");
+  }
+  mag=delta<0?-delta:delta;
+  return sprintf(str,"%c%lu.%09u s",delta<0?'-':'+',
+		 (unsigned long)(mag/1000000000),
+		 (unsigned)(mag%1000000000));
+}
@@ -0,0 +1,70 @@
+// hexdump.h
+//
+// Table-driven hexdump formatter for lwmultcap(1)
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef HEXDUMP_H
+#define HEXDUMP_H
+
+#include <stdint.h>
+
+#include "outputbuffer.h"
+
+//
+// Length of one full 16-byte row, including the newline
+//
+#define HEXDUMP_ROW_SIZE 79
+
+//
+// Passed as the 'delta' when there is no previous packet to measure from
+//
+#define HEXDUMP_NO_DELTA INT64_MIN
+
+class HexDump
+{
+ public:
+  HexDump();
+  void setShowRuler(bool state);
+  void setShowTime(bool state);
+  void formatPacket(OutputBuffer *out,uint32_t dst_addr,uint16_t dst_port,
+		    uint32_t src_addr,uint16_t src_port,
+		    const char *data,int len,uint64_t timestamp=0,
+		    int64_t delta=HEXDUMP_NO_DELTA) const;
+  void formatHeader(OutputBuffer *out,uint32_t dst_addr,uint16_t dst_port,
+		    uint32_t src_addr,uint16_t src_port,int len,
+		    uint64_t timestamp=0,int64_t delta=HEXDUMP_NO_DELTA) const;
+  void formatRows(OutputBuffer *out,const char *data,int len) const;
+  void formatRow(OutputBuffer *out,const char *data,int len,
+		 unsigned offset) const;
+  void formatFooter(OutputBuffer *out) const;
+  static unsigned formatAddress(char *str,uint32_t addr);
+  static unsigned formatAddress(char *str,uint32_t addr,uint16_t port);
+  static unsigned formatTime(char *str,uint64_t timestamp);
+  static unsigned formatDelta(char *str,int64_t delta);
+
+ private:
+  char *FormatRow(char *row,unsigned offset,const uint8_t *data,
+		  int len) const;
+  bool dump_show_ruler;
+  bool dump_show_time;
+  char dump_hex[256][3];
+  char dump_ascii[256];
+};
+
+
+#endif  // HEXDUMP_H
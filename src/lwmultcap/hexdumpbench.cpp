@@ -0,0 +1,185 @@
+// hexdumpbench.cpp
+//
+// Throughput benchmark for the lwmultcap(1) hexdump formatter
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+//   Usage: hexdumpbench [<packets> [<packet-size>]]
+//
+//   Formats the same synthetic packets with HexDump and with a
+//   printf()-per-byte formatter equivalent to the one it replaced,
+//   checks that the two produce identical output, then times each
+//   writing to /dev/null.
+//
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "hexdump.h"
+
+#define BENCH_DST_ADDR 0xEFC0FF03
+#define BENCH_DST_PORT 4001
+#define BENCH_SRC_ADDR 0xC0A80A1E
+#define BENCH_SRC_PORT 49152
+
+void LegacyFormat(FILE *f,const char *data,int len)
+{
+  char dst_str[24];
+  char src_str[24];
+  char size_str[16];
+
+  HexDump::formatAddress(dst_str,BENCH_DST_ADDR,BENCH_DST_PORT);
+  HexDump::formatAddress(src_str,BENCH_SRC_ADDR,BENCH_SRC_PORT);
+  snprintf(size_str,16,"0x%04X",len);
+  fprintf(f,"------------------------------------------------------------------------------\n");
+  fprintf(f,"| To: %-21s    From: %-21s     size: %-7s |\n",
+	  dst_str,src_str,size_str);
+  fprintf(f,"------------------------------------------------------------------------------\n");
+  fprintf(f,"| Offset  0- 1- 2- 3- 4- 5- 6- 7- 8- 9- A- B- C- D- E- F- | 0123456789ABCDEF |\n");
+  fprintf(f,"----------------------------------------------------------|------------------|\n");
+  for(int i=0;i<len;i+=16) {
+    std::string str="";
+    fprintf(f,"| 0x%04X: ",i);
+    for(int j=0;j<16;j++) {
+      if((i+j)<len) {
+	char c=0xFF&data[i+j];
+	fprintf(f,"%02X ",0xFF&c);
+	if((c>=' ')&&(c<='~')) {
+	  str+=c;
+	}
+	else {
+	  str+='.';
+	}
+      }
+      else {
+	fprintf(f,"   ");
+	str+=' ';
+      }
+    }
+    fprintf(f,"| %s |\n",str.c_str());
+  }
+  fprintf(f,"------------------------------------------------------------------------------\n");
+}
+
+
+double Now()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return (double)ts.tv_sec+(double)ts.tv_nsec/1000000000.0;
+}
+
+
+int main(int argc,char *argv[])
+{
+  unsigned packets=100000;
+  int size=1440;
+  HexDump dump;
+  OutputBuffer out;
+  char *data;
+  char *mem=NULL;
+  size_t mem_len=0;
+  FILE *f;
+  int fd;
+  double start;
+  double legacy_secs;
+  double dump_secs;
+  uint64_t bytes=0;
+
+  if(argc>1) {
+    packets=strtoul(argv[1],NULL,10);
+  }
+  if(argc>2) {
+    size=strtoul(argv[2],NULL,10);
+  }
+  data=new char[size];
+  for(int i=0;i<size;i++) {
+    data[i]=0xFF&(i*37+11);
+  }
+
+  //
+  // Verify that the output is identical, including a partial last row
+  //
+  for(int len=0;len<=size;len+=(len<48?1:size/7+1)) {
+    f=open_memstream(&mem,&mem_len);
+    LegacyFormat(f,data,len);
+    fclose(f);
+    out.clear();
+    dump.formatPacket(&out,BENCH_DST_ADDR,BENCH_DST_PORT,
+		      BENCH_SRC_ADDR,BENCH_SRC_PORT,data,len);
+    if((mem_len!=out.size())||(memcmp(mem,out.data(),mem_len)!=0)) {
+      fprintf(stderr,"hexdumpbench: output mismatch at %d bytes\n",len);
+      exit(1);
+    }
+    free(mem);
+    mem=NULL;
+  }
+
+  if((fd=open("/dev/null",O_WRONLY))<0) {
+    perror("hexdumpbench");
+    exit(1);
+  }
+
+  //
+  // Legacy formatter
+  //
+  f=fdopen(dup(fd),"w");
+  start=Now();
+  for(unsigned i=0;i<packets;i++) {
+    LegacyFormat(f,data,size);
+  }
+  fflush(f);
+  legacy_secs=Now()-start;
+  fclose(f);
+
+  //
+  // Table-driven formatter, flushing every 32 packets as lwmultcap(1)
+  // would with its default batch size
+  //
+  out.clear();
+  start=Now();
+  for(unsigned i=0;i<packets;i++) {
+    dump.formatPacket(&out,BENCH_DST_ADDR,BENCH_DST_PORT,
+		      BENCH_SRC_ADDR,BENCH_SRC_PORT,data,size);
+    if((i%32)==31) {
+      bytes+=out.size();
+      out.flush(fd);
+    }
+  }
+  bytes+=out.size();
+  out.flush(fd);
+  dump_secs=Now()-start;
+  close(fd);
+
+  printf("%u packets of %d bytes (%.1f MB of text)\n",packets,size,
+	 (double)bytes/1000000.0);
+  printf("  printf():  %10.0f packets/sec  %8.1f MB/sec\n",
+	 (double)packets/legacy_secs,(double)bytes/legacy_secs/1000000.0);
+  printf("  HexDump:   %10.0f packets/sec  %8.1f MB/sec\n",
+	 (double)packets/dump_secs,(double)bytes/dump_secs/1000000.0);
+  printf("  speedup:   %10.1fx\n",legacy_secs/dump_secs);
+
+  delete[] data;
+
+  return 0;
+}
@@ -0,0 +1,184 @@
+// lwadvparser.cpp
+//
+// Zero-copy parser for Livewire advertisement packets
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <string.h>
+
+#include "lwadvparser.h"
+
+//
+// Header signature
+//
+static const uint8_t lwadv_signature[]={0x03,0x00,0x02,0x07};
+
+//
+// TLV value types. Strings carry their own 16 bit length; the size of
+// everything else is fixed by the type. A type not listed here ends the
+// walk, since there's no telling where the next TLV starts.
+//
+#define LWADV_TYPE_STRING 0x03
+static const int lwadv_type_sizes[16]=
+  {-1,4,-1,-2,-1,-1,-1,1,2,4,8,-1,-1,-1,-1,-1};  // -2 is a string
+
+//
+// Source tags
+//
+#define LWADV_TAG_SOURCE "PSID"
+#define LWADV_TAG_NAME "LABL"
+#define LWADV_TAG_STREAM "FSID"
+#define LWADV_TAG_CHANNELS "NCHN"
+
+bool LwAdvTlv::is(const char *t) const
+{
+  return memcmp(tag,t,4)==0;
+}
+
+
+uint32_t LwAdvTlv::toUInt() const
+{
+  uint32_t val=0;
+
+  if((type==LWADV_TYPE_STRING)||(length>4)) {
+    return 0;
+  }
+  for(unsigned i=0;i<length;i++) {
+    val=(val<<8)|value[i];
+  }
+  return val;
+}
+
+
+LwAdvParser::LwAdvParser(const char *data,unsigned len)
+{
+  adv_data=(const uint8_t *)data;
+  adv_length=len;
+  rewind();
+}
+
+
+bool LwAdvParser::isAdvertisement() const
+{
+  return (adv_length>=LWADV_HEADER_SIZE)&&
+    (memcmp(adv_data,lwadv_signature,sizeof(lwadv_signature))==0);
+}
+
+
+uint32_t LwAdvParser::sequence() const
+{
+  if(adv_length<8) {
+    return 0;
+  }
+  return ((uint32_t)adv_data[4]<<24)|(adv_data[5]<<16)|(adv_data[6]<<8)|
+    adv_data[7];
+}
+
+
+bool LwAdvParser::nextTlv(LwAdvTlv *tlv)
+{
+  const uint8_t *p=adv_data+adv_pos;
+  unsigned avail=adv_length-adv_pos;
+  int size;
+
+  if((!isAdvertisement())||adv_truncated||(avail==0)) {
+    return false;
+  }
+  if((avail<5)||(p[4]>0x0F)||((size=lwadv_type_sizes[p[4]])==-1)) {
+    adv_truncated=true;
+    return false;
+  }
+  tlv->tag=(const char *)p;
+  tlv->type=p[4];
+  if(size==-2) {
+    if(avail<7) {
+      adv_truncated=true;
+      return false;
+    }
+    tlv->length=(p[5]<<8)|p[6];
+    tlv->value=p+7;
+  }
+  else {
+    tlv->length=size;
+    tlv->value=p+5;
+  }
+  if((tlv->value+tlv->length)>(adv_data+adv_length)) {
+    adv_truncated=true;
+    return false;
+  }
+  adv_pos=(tlv->value+tlv->length)-adv_data;
+
+  return true;
+}
+
+
+bool LwAdvParser::nextSource(LwAdvSource *src)
+{
+  LwAdvTlv tlv;
+  unsigned pos;
+
+  //
+  // Find the start of the next source
+  //
+  do {
+    if(!nextTlv(&tlv)) {
+      return false;
+    }
+  } while(!tlv.is(LWADV_TAG_SOURCE));
+  memset(src,0,sizeof(LwAdvSource));
+  src->number=tlv.toUInt();
+
+  //
+  // Collect its fields, stopping short of the next one
+  //
+  pos=adv_pos;
+  while(nextTlv(&tlv)) {
+    if(tlv.is(LWADV_TAG_SOURCE)) {
+      adv_pos=pos;
+      break;
+    }
+    if(tlv.is(LWADV_TAG_NAME)&&(tlv.type==LWADV_TYPE_STRING)) {
+      src->name=(const char *)tlv.value;
+      src->name_length=tlv.length;
+    }
+    if(tlv.is(LWADV_TAG_STREAM)) {
+      src->stream_address=tlv.toUInt();
+    }
+    if(tlv.is(LWADV_TAG_CHANNELS)) {
+      src->channels=tlv.toUInt();
+    }
+    pos=adv_pos;
+  }
+
+  return true;
+}
+
+
+bool LwAdvParser::isTruncated() const
+{
+  return adv_truncated;
+}
+
+
+void LwAdvParser::rewind()
+{
+  adv_pos=LWADV_HEADER_SIZE;
+  adv_truncated=false;
+  if(adv_pos>adv_length) {
+    adv_pos=adv_length;
+  }
+}
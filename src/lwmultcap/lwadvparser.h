@@ -0,0 +1,85 @@
+// lwadvparser.h
+//
+// Zero-copy parser for Livewire advertisement packets
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+//   This file has no Qt dependencies, so that it can be linked into
+//   other programs wishing to decode Livewire advertisements.
+//
+
+#ifndef LWADVPARSER_H
+#define LWADVPARSER_H
+
+#include <stdint.h>
+
+//
+// Advertisements are sent to 239.192.255.3, port 4001. After a fixed
+// header comes a run of TLVs, each a four character ASCII tag, a one
+// byte type code and a value whose size is set by the type. Each
+// source's TLVs start with a 'PSID' giving its number.
+//
+#define LWADV_ADDRESS 0xEFC0FF03
+#define LWADV_PORT 4001
+#define LWADV_HEADER_SIZE 16
+
+//
+// One TLV; 'value' points into the packet
+//
+struct LwAdvTlv
+{
+  const char *tag;  // Four characters, not NUL terminated
+  uint8_t type;
+  const uint8_t *value;
+  unsigned length;
+  bool is(const char *t) const;
+  uint32_t toUInt() const;
+};
+
+
+//
+// The fields of one advertised source; 'name' points into the packet
+//
+struct LwAdvSource
+{
+  uint32_t number;
+  uint32_t stream_address;
+  unsigned channels;  // Zero if not advertised
+  const char *name;   // Not NUL terminated
+  unsigned name_length;
+};
+
+
+class LwAdvParser
+{
+ public:
+  LwAdvParser(const char *data,unsigned len);
+  bool isAdvertisement() const;
+  uint32_t sequence() const;
+  bool nextTlv(LwAdvTlv *tlv);
+  bool nextSource(LwAdvSource *src);
+  bool isTruncated() const;
+  void rewind();
+
+ private:
+  const uint8_t *adv_data;
+  unsigned adv_length;
+  unsigned adv_pos;
+  bool adv_truncated;
+};
+
+
+#endif  // LWADVPARSER_H
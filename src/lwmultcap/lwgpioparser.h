@@ -0,0 +1,89 @@
+// lwgpioparser.h
+//
+// Zero-copy parser for Livewire GPIO multicast packets
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+//   This file has no Qt dependencies, so that it can be linked into
+//   other programs wishing to decode Livewire GPIO traffic.
+//
+
+#ifndef LWGPIOPARSER_H
+#define LWGPIOPARSER_H
+
+#include <stdint.h>
+
+//
+// GPIO state is sent to 239.192.255.4. Each packet is a four byte
+// header, the first byte of which is the message type, followed by
+// four byte records:
+//
+//   Offset  Size  Contents
+//   0       2     Port (Livewire channel) number, big-endian
+//   2       1     Pin states, bit 0 for pin 1; set when the pin is low
+//   3       1     Mask of the pins whose state is being reported
+//
+#define LWGPIO_ADDRESS 0xEFC0FF04
+#define LWGPIO_PORT 2055
+#define LWGPIO_HEADER_SIZE 4
+#define LWGPIO_RECORD_SIZE 4
+#define LWGPIO_TYPE_STATE 0x01
+#define LWGPIO_PINS 5
+#define LWGPIO_MAX_PORTS 65536
+
+struct LwGpioRecord
+{
+  uint16_t port;
+  uint8_t states;
+  uint8_t mask;
+};
+
+
+class LwGpioParser
+{
+ public:
+  LwGpioParser(const char *data,unsigned len)
+  {
+    gpio_data=(const uint8_t *)data;
+    gpio_length=len;
+    gpio_pos=LWGPIO_HEADER_SIZE;
+  }
+  bool isGpio() const
+  {
+    return (gpio_length>=LWGPIO_HEADER_SIZE)&&
+      (gpio_data[0]==LWGPIO_TYPE_STATE)&&
+      (((gpio_length-LWGPIO_HEADER_SIZE)%LWGPIO_RECORD_SIZE)==0);
+  }
+  bool nextRecord(LwGpioRecord *rec)
+  {
+    if((!isGpio())||((gpio_pos+LWGPIO_RECORD_SIZE)>gpio_length)) {
+      return false;
+    }
+    rec->port=(gpio_data[gpio_pos]<<8)|gpio_data[gpio_pos+1];
+    rec->states=gpio_data[gpio_pos+2];
+    rec->mask=gpio_data[gpio_pos+3];
+    gpio_pos+=LWGPIO_RECORD_SIZE;
+    return true;
+  }
+
+ private:
+  const uint8_t *gpio_data;
+  unsigned gpio_length;
+  unsigned gpio_pos;
+};
+
+
+#endif  // LWGPIOPARSER_H
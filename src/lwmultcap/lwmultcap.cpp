@@ -19,48 +19,178 @@
 //
 
 #include <errno.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
 #include <sys/ioctl.h>
+#include <sys/signalfd.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <signal.h>
 #include <netinet/in.h>
 #include <netinet/ip.h>
 #include <net/if.h>
+#include <time.h>
 #include <unistd.h>
 #include <stdint.h>
 
+#include <algorithm>
+
 #include <QCoreApplication>
 #include <QStringList>
 
+#include "bpffilter.h"
 #include "cmdswitch.h"
+#include "lwadvparser.h"
+#include "lwgpioparser.h"
 #include "lwmultcap.h"
 
+static uint64_t MonotonicNow()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return (uint64_t)ts.tv_sec*1000000000+ts.tv_nsec;
+}
+
+
 MainObject::MainObject(QObject *parent)
   : QObject(parent)
 {
   unsigned port=0;
   QString err_msg;
+  QString recorder_switch;
   bool ok=false;
 
   c_port=0;
+  c_epoll_fd=-1;
+  c_epoll_notifier=NULL;
+  c_total_slots=0;
+  c_msgs=NULL;
+  c_iovs=NULL;
+  c_names=NULL;
+  c_pkts=NULL;
+  c_order=NULL;
+  c_signal_fd=-1;
+  c_signal_notifier=NULL;
+  c_read_timer=NULL;
+  c_duration_timer=NULL;
+  c_stats_timer=NULL;
+  c_report_timer=NULL;
+  c_dup_report_timer=NULL;
+  c_flush_timer=NULL;
+  c_duration=0;
+  c_report_interval=0;
+  c_report_received=0;
+  c_report_output=0;
+  c_finished=false;
+  c_mode=MainObject::ModeHexdump;
+  c_format=MainObject::FormatText;
+  c_output_fd=1;
+  c_pcapng=NULL;
+  c_source_stats=NULL;
+  c_timing_stats=NULL;
+  c_rtp_stats=NULL;
+  c_dup_filter=NULL;
+  c_reader=NULL;
+  c_read_paced=false;
+  c_read_pending=false;
+  c_read_started=0;
+  c_read_elapsed=0;
+  c_read_first_timestamp=0;
+  c_dup_window=0;
+  c_rate_limiter=NULL;
+  c_sample_interval=1;
+  c_max_rate=0;
+  c_show_timing=false;
+  c_filter_expr=NULL;
+  c_recorder=NULL;
+  c_ring_packets=FLIGHTRECORDER_DEFAULT_PACKETS;
+  c_ring_seconds=0;
+  c_trigger_expr=NULL;
+  c_post_trigger=FLIGHTRECORDER_DEFAULT_POST_TRIGGER;
+  c_post_trigger_remaining=0;
+  c_recorder_dumps=0;
+  c_adv_decoder=NULL;
+  c_gpio_decoder=NULL;
+  c_transitions_only=false;
+  c_source_stats_rendered=0;
+  c_source_stats_last=0;
   c_show_ruler=true;
   c_first_offset=-1;
   c_last_offset=-1;
   c_packet_limit=0;
+  c_output=new OutputBuffer();
+  c_hexdump=new HexDump();
+  c_delta_dump=NULL;
+  c_packet_formatter=NULL;
+  c_payload_encoding=PacketFormatter::EncodingHex;
+  c_format_pool=NULL;
+  c_workers=0;
+  c_batch_size=LWMULTCAP_DEFAULT_BATCH_SIZE;
+  c_show_batch_stats=false;
+  c_kernel_filter=true;
+  c_kernel_filter_active=false;
+  c_kernel_filter_sources=false;
+  c_kernel_filter_excludes=false;
+  c_kernel_filter_mismatches=0;
+  c_batch_calls=0;
+  c_batch_packets=0;
+  c_batch_full=0;
 
   //
   // Process command-line switches
   //
   CmdSwitch *cmd=new CmdSwitch("lwmultcap",LWMULTCAP_USAGE);
   for(unsigned i=0;i<cmd->keys();i++) {
+    if(cmd->key(i)=="-d") {
+      cmd->setProcessed(i,true);
+    }
+
+    if(cmd->key(i)=="--batch") {
+      c_batch_size=ReadIntegerArg(cmd->value(i),&ok);
+      if((!ok)||(c_batch_size==0)||(c_batch_size>LWMULTCAP_MAX_BATCH_SIZE)) {
+	fprintf(stderr,"lwmultcap: invalid \"--batch\" value\n");
+	exit(1);
+      }
+      c_show_batch_stats=true;
+      cmd->setProcessed(i,true);
+    }
+
+    if(cmd->key(i)=="--duration") {
+      c_duration=ReadIntegerArg(cmd->value(i),&ok);
+      if((!ok)||(c_duration==0)) {
+	fprintf(stderr,"lwmultcap: invalid \"--duration\" value\n");
+	exit(1);
+      }
+      cmd->setProcessed(i,true);
+    }
+
+    if(cmd->key(i)=="--filter") {
+      c_filter_exprs.push_back(cmd->value(i));
+      cmd->setProcessed(i,true);
+    }
+
     if(cmd->key(i)=="--filter-source-address") {
-      QHostAddress addr;
-      if(!addr.setAddress(cmd->value(i))) {
+      uint32_t addr;
+      unsigned prefix_len;
+      if(!ReadNetworkArg(cmd->value(i),&addr,&prefix_len)) {
 	fprintf(stderr,
 		"lwmultcap: invalid \"--filter-source-address\" value\n");
 	exit(1);
       }
-      c_filter_source_addresses.push_back(addr);
+      c_filter_sources.insert(addr,prefix_len);
+      cmd->setProcessed(i,true);
+    }
+
+    if(cmd->key(i)=="--exclude-source-address") {
+      uint32_t addr;
+      unsigned prefix_len;
+      if(!ReadNetworkArg(cmd->value(i),&addr,&prefix_len)) {
+	fprintf(stderr,
+		"lwmultcap: invalid \"--exclude-source-address\" value\n");
+	exit(1);
+      }
+      c_exclude_sources.insert(addr,prefix_len);
       cmd->setProcessed(i,true);
     }
 
@@ -96,7 +226,7 @@ MainObject::MainObject(QObject *parent)
 	exit(1);
       }
       f0.removeFirst();
-      c_filter_strings[offset]=f0.join(":");
+      c_filter_strings[offset]=f0.join(":").toUtf8();
       cmd->setProcessed(i,true);
     }
 
@@ -109,6 +239,23 @@ MainObject::MainObject(QObject *parent)
       cmd->setProcessed(i,true);
     }
 
+    if(cmd->key(i)=="--format") {
+      if(cmd->value(i).toLower()=="text") {
+	c_format=MainObject::FormatText;
+      }
+      else if(cmd->value(i).toLower()=="json") {
+	c_format=MainObject::FormatJson;
+      }
+      else if(cmd->value(i).toLower()=="csv") {
+	c_format=MainObject::FormatCsv;
+      }
+      else {
+	fprintf(stderr,"lwmultcap: invalid \"--format\" value\n");
+	exit(1);
+      }
+      cmd->setProcessed(i,true);
+    }
+
     if(cmd->key(i)=="--iface-address") {
       if(!c_iface_address.setAddress(cmd->value(i))) {
 	fprintf(stderr,"lwmultcap: invalid interface address\n");
@@ -137,10 +284,60 @@ MainObject::MainObject(QObject *parent)
     }
 
     if(cmd->key(i)=="--mcast-address") {
-      if(!c_mcast_address.setAddress(cmd->value(i))) {
+      Group group;
+      QStringList f0=cmd->value(i).split(":",Qt::KeepEmptyParts);
+      if((f0.size()>2)||(!group.address.setAddress(f0.at(0)))) {
 	fprintf(stderr,"lwmultcap: invalid multicast address\n");
 	exit(1);
       }
+      group.port=0;  // Use the "--port" value
+      if(f0.size()==2) {
+	port=ReadIntegerArg(f0.at(1),&ok);
+	if((!ok)||(port==0)||(port>0xFFFF)) {
+	  fprintf(stderr,"lwmultcap: invalid port value\n");
+	  exit(1);
+	}
+	group.port=port;
+      }
+      group.sock=-1;
+      c_groups.push_back(group);
+      cmd->setProcessed(i,true);
+    }
+
+    if(cmd->key(i)=="--mode") {
+      if(cmd->value(i).toLower()=="hexdump") {
+	c_mode=MainObject::ModeHexdump;
+      }
+      else if(cmd->value(i).toLower()=="delta") {
+	c_mode=MainObject::ModeDelta;
+      }
+      else if(cmd->value(i).toLower()=="pcapng") {
+	c_mode=MainObject::ModePcapng;
+      }
+      else if(cmd->value(i).toLower()=="stats") {
+	c_mode=MainObject::ModeStats;
+      }
+      else if(cmd->value(i).toLower()=="advert") {
+	c_mode=MainObject::ModeAdvert;
+      }
+      else if(cmd->value(i).toLower()=="gpio") {
+	c_mode=MainObject::ModeGpio;
+      }
+      else if(cmd->value(i).toLower()=="recorder") {
+	c_mode=MainObject::ModeRecorder;
+      }
+      else if(cmd->value(i).toLower()=="rtp") {
+	c_mode=MainObject::ModeRtp;
+      }
+      else {
+	fprintf(stderr,"lwmultcap: invalid \"--mode\" value\n");
+	exit(1);
+      }
+      cmd->setProcessed(i,true);
+    }
+
+    if(cmd->key(i)=="--no-kernel-filter") {
+      c_kernel_filter=false;
       cmd->setProcessed(i,true);
     }
 
@@ -149,6 +346,35 @@ MainObject::MainObject(QObject *parent)
       cmd->setProcessed(i,true);
     }
 
+    if(cmd->key(i)=="--output-file") {
+      c_output_filename=cmd->value(i);
+      cmd->setProcessed(i,true);
+    }
+
+    if(cmd->key(i)=="--payload-encoding") {
+      if(cmd->value(i).toLower()=="hex") {
+	c_payload_encoding=PacketFormatter::EncodingHex;
+      }
+      else if(cmd->value(i).toLower()=="base64") {
+	c_payload_encoding=PacketFormatter::EncodingBase64;
+      }
+      else {
+	fprintf(stderr,"lwmultcap: invalid \"--payload-encoding\" value\n");
+	exit(1);
+      }
+      cmd->setProcessed(i,true);
+    }
+
+    if(cmd->key(i)=="--paced") {
+      c_read_paced=true;
+      cmd->setProcessed(i,true);
+    }
+
+    if(cmd->key(i)=="--read-file") {
+      c_read_filename=cmd->value(i);
+      cmd->setProcessed(i,true);
+    }
+
     if(cmd->key(i)=="--packet-limit") {
       c_packet_limit=ReadIntegerArg(cmd->value(i),&ok);
       if(!ok) {
@@ -158,11 +384,102 @@ MainObject::MainObject(QObject *parent)
       cmd->setProcessed(i,true);
     }
 
+    if(cmd->key(i)=="--report-interval") {
+      c_report_interval=ReadIntegerArg(cmd->value(i),&ok);
+      if((!ok)||(c_report_interval==0)) {
+	fprintf(stderr,"lwmultcap: invalid \"--report-interval\" value\n");
+	exit(1);
+      }
+      cmd->setProcessed(i,true);
+    }
+
+    if(cmd->key(i)=="--post-trigger") {
+      c_post_trigger=ReadIntegerArg(cmd->value(i),&ok);
+      if(!ok) {
+	fprintf(stderr,"lwmultcap: invalid \"--post-trigger\" value\n");
+	exit(1);
+      }
+      recorder_switch="--post-trigger";
+      cmd->setProcessed(i,true);
+    }
+
+    if(cmd->key(i)=="--ring-packets") {
+      c_ring_packets=ReadIntegerArg(cmd->value(i),&ok);
+      if((!ok)||(c_ring_packets==0)) {
+	fprintf(stderr,"lwmultcap: invalid \"--ring-packets\" value\n");
+	exit(1);
+      }
+      recorder_switch="--ring-packets";
+      cmd->setProcessed(i,true);
+    }
+
+    if(cmd->key(i)=="--ring-seconds") {
+      c_ring_seconds=ReadIntegerArg(cmd->value(i),&ok);
+      if((!ok)||(c_ring_seconds==0)) {
+	fprintf(stderr,"lwmultcap: invalid \"--ring-seconds\" value\n");
+	exit(1);
+      }
+      recorder_switch="--ring-seconds";
+      cmd->setProcessed(i,true);
+    }
+
     if(cmd->key(i)=="--show-ruler") {
       c_show_ruler=true;
       cmd->setProcessed(i,true);
     }
 
+    if(cmd->key(i)=="--dedupe") {
+      c_dup_window=ReadIntegerArg(cmd->value(i),&ok);
+      if((!ok)||(c_dup_window==0)) {
+	fprintf(stderr,"lwmultcap: invalid \"--dedupe\" value\n");
+	exit(1);
+      }
+      cmd->setProcessed(i,true);
+    }
+
+    if(cmd->key(i)=="--max-rate") {
+      c_max_rate=ReadIntegerArg(cmd->value(i),&ok);
+      if((!ok)||(c_max_rate==0)) {
+	fprintf(stderr,"lwmultcap: invalid \"--max-rate\" value\n");
+	exit(1);
+      }
+      cmd->setProcessed(i,true);
+    }
+
+    if(cmd->key(i)=="--sample") {
+      c_sample_interval=ReadIntegerArg(cmd->value(i),&ok);
+      if((!ok)||(c_sample_interval==0)) {
+	fprintf(stderr,"lwmultcap: invalid \"--sample\" value\n");
+	exit(1);
+      }
+      cmd->setProcessed(i,true);
+    }
+
+    if(cmd->key(i)=="--timing") {
+      c_show_timing=true;
+      cmd->setProcessed(i,true);
+    }
+
+    if(cmd->key(i)=="--trigger") {
+      c_trigger_exprs.push_back(cmd->value(i));
+      recorder_switch="--trigger";
+      cmd->setProcessed(i,true);
+    }
+
+    if(cmd->key(i)=="--transitions-only") {
+      c_transitions_only=true;
+      cmd->setProcessed(i,true);
+    }
+
+    if(cmd->key(i)=="--workers") {
+      c_workers=ReadIntegerArg(cmd->value(i),&ok);
+      if((!ok)||(c_workers==0)||(c_workers>FORMATPOOL_MAX_WORKERS)) {
+	fprintf(stderr,"lwmultcap: invalid \"--workers\" value\n");
+	exit(1);
+      }
+      cmd->setProcessed(i,true);
+    }
+
     if(!cmd->processed(i)) {
       fprintf(stderr,"lwmultcap: unknown option \"%s\"\n",
 	      cmd->key(i).toUtf8().constData());
@@ -170,234 +487,1298 @@ MainObject::MainObject(QObject *parent)
     }
   }
 
+  if(cmd->debugActive()) {
+    c_show_batch_stats=true;
+  }
+
+  c_hexdump->setShowRuler(c_show_ruler);
+  c_hexdump->setShowTime(c_show_timing);
+
   //
   // Sanity Checks
   //
-  if(c_iface_address.isNull()) {
-    fprintf(stderr,"lwmultcap: you must specify \"--iface-address\"\n");
+  if(c_iface_address.isNull()&&c_read_filename.isEmpty()) {
+    fprintf(stderr,"lwmultcap: you must specify \"--iface-address\" or \"--read-file\"\n");
     exit(1);
   }
-  if(c_mcast_address.isNull()) {
-    fprintf(stderr,"lwmultcap: you must specify \"--mcast-address\"\n");
+  if((!c_iface_address.isNull())&&(!c_read_filename.isEmpty())) {
+    fprintf(stderr,"lwmultcap: \"--iface-address\" and \"--read-file\" are mutually exclusive\n");
     exit(1);
   }
-  if(c_port==0) {
-    fprintf(stderr,"lwmultcap: you must specify \"--port\"\n");
+  if((c_format==MainObject::FormatCsv)&&(c_mode!=MainObject::ModeHexdump)&&
+     (c_mode!=MainObject::ModeRecorder)) {
+    fprintf(stderr,"lwmultcap: \"--format=csv\" is supported only in hexdump and recorder modes\n");
     exit(1);
   }
-
-  //
-  // Receive Socket
-  //
-  int sock;
-  if((sock=socket(AF_INET,SOCK_DGRAM,0))<0) {
-    fprintf(stderr,"lwmultcap: unable to create socket [%s]\n",strerror(errno));
+  if((!recorder_switch.isEmpty())&&(c_mode!=MainObject::ModeRecorder)) {
+    fprintf(stderr,"lwmultcap: \"%s\" requires \"--mode=recorder\"\n",
+	    recorder_switch.toUtf8().constData());
     exit(1);
   }
-
-  //
-  // So we can get the actual delivery address
-  //
-  unsigned optval=1;
-  if(setsockopt(sock,IPPROTO_IP,IP_PKTINFO,&optval,sizeof(unsigned))!=0) {
-    fprintf(stderr,"lwmultcap: unable to set IP_PKTINFO [%s] on socket\n",
-	    strerror(errno));
+  if((c_workers>0)&&(((c_mode!=MainObject::ModeHexdump)&&
+		       (c_mode!=MainObject::ModeAdvert))||c_show_timing)) {
+    fprintf(stderr,"lwmultcap: \"--workers\" is supported only in hexdump and advert modes, without \"--timing\"\n");
     exit(1);
   }
-  sockaddr_in sa;
-  memset(&sa,0,sizeof(sa));
-  sa.sin_port=htons(c_port);
-  if(bind(sock,(struct sockaddr *)(&sa),sizeof(sa))<0) {
-    fprintf(stderr,"lwmultcap: unable to bind socket [%s]\n",strerror(errno));
+  if((c_packet_limit>0)&&(c_mode==MainObject::ModeRecorder)) {
+    fprintf(stderr,"lwmultcap: \"--packet-limit\" cannot be used in recorder mode\n");
     exit(1);
   }
-  if(!Subscribe(sock,c_mcast_address,c_iface_address,&err_msg)) {
-    fprintf(stderr,"lwmultcap: unable to subscribe to %s [%s]\n",
-	    c_mcast_address.toString().toUtf8().constData(),strerror(errno));
+  if(c_read_paced&&c_read_filename.isEmpty()) {
+    fprintf(stderr,"lwmultcap: \"--paced\" requires \"--read-file\"\n");
     exit(1);
   }
-
-  MainLoop(sock);
-}
-
-
-void MainObject::MainLoop(int sock)
-{
-  QHostAddress dst_addr;
-  QHostAddress src_addr;
-  uint16_t src_port=0;
-  ssize_t n;
-  struct msghdr msg;
-  memset(&msg,0,sizeof(msg));
-
-  char name[sizeof(struct sockaddr_in)];
-  memset(&name,0,sizeof(struct sockaddr_in));
-  msg.msg_name=name;
-  msg.msg_namelen=sizeof(struct sockaddr_in);
-  
-  char data[1500];
-  struct iovec iov;
-  memset(&iov,0,sizeof(iov));
-  iov.iov_base=data;
-  iov.iov_len=1500;
-  msg.msg_iov=&iov;
-  msg.msg_iovlen=1;
-
-  char cmsgs[1024];
-  memset(cmsgs,0,1024);
-  msg.msg_control=cmsgs;
-  msg.msg_controllen=1024;
-  
-  while((n=recvmsg(sock,&msg,0))>0) {
-    if(msg.msg_flags!=0) {
-      fprintf(stderr,"lwmultcap: error flags received!\n");
-      exit(1);
+  if((c_groups.size()==0)&&(c_mode==MainObject::ModeAdvert)) {
+    Group group;
+    group.address.setAddress(LWADV_ADDRESS);
+    group.port=LWADV_PORT;
+    group.sock=-1;
+    c_groups.push_back(group);
+  }
+  if((c_groups.size()==0)&&(c_mode==MainObject::ModeGpio)) {
+    Group group;
+    group.address.setAddress(LWGPIO_ADDRESS);
+    group.port=0;  // Use the "--port" value, if any
+    if(c_port==0) {
+      group.port=LWGPIO_PORT;
+    }
+    group.sock=-1;
+    c_groups.push_back(group);
+  }
+  if((c_groups.size()==0)&&c_read_filename.isEmpty()) {
+    fprintf(stderr,"lwmultcap: you must specify \"--mcast-address\"\n");
+    exit(1);
+  }
+  if(c_groups.size()>LWMULTCAP_MAX_GROUPS) {
+    fprintf(stderr,"lwmultcap: too many multicast groups (max %d)\n",
+	    LWMULTCAP_MAX_GROUPS);
+    exit(1);
+  }
+  for(int i=0;i<c_groups.size();i++) {
+    if(c_groups.at(i).port==0) {
+      if(c_port==0) {
+	fprintf(stderr,"lwmultcap: you must specify \"--port\" or give a port for %s\n",
+		c_groups.at(i).address.toString().toUtf8().constData());
+	exit(1);
+      }
+      c_groups[i].port=c_port;
     }
-    struct sockaddr_in sa;
-    memcpy(&sa,msg.msg_name,sizeof(sa));
-    src_addr.setAddress(ntohl(sa.sin_addr.s_addr));
-    src_port=ntohs(sa.sin_port);
-    
-    struct cmsghdr *cmsg;
-    cmsg=CMSG_FIRSTHDR(&msg);
-    while(cmsg!=NULL) {
-      if(cmsg->cmsg_type==8) {
-	struct in_pktinfo pktinfo;
-	memcpy(&pktinfo,CMSG_DATA(cmsg),sizeof(pktinfo));
-	dst_addr.setAddress((ntohl(pktinfo.ipi_addr.s_addr)));
+    for(int j=0;j<i;j++) {
+      if((c_groups.at(j).address==c_groups.at(i).address)&&
+	 (c_groups.at(j).port==c_groups.at(i).port)) {
+	fprintf(stderr,"lwmultcap: %s:%u specified more than once\n",
+		c_groups.at(i).address.toString().toUtf8().constData(),
+		c_groups.at(i).port);
+	exit(1);
       }
-      cmsg=CMSG_NXTHDR(&msg,cmsg);
     }
-    
-    ProcessPacket(dst_addr,src_addr,src_port,QByteArray(data,n));
   }
 
-  fprintf(stderr,"lwmultcap: socket error [%s]\n",strerror(errno));
-  exit(1);
-}
-
+  if((c_mode==MainObject::ModePcapng)&&
+     (c_output_filename.isEmpty()||(c_output_filename=="-"))&&isatty(1)) {
+    fprintf(stderr,"lwmultcap: refusing to write pcapng data to a terminal\n");
+    exit(1);
+  }
 
-void MainObject::ProcessPacket(const QHostAddress &dst_addr,
-				const QHostAddress &src_addr,uint16_t src_port,
-				QByteArray data)
-{
-  bool match=false;
+  //
+  // Filter Expressions
+  //
+  // Several are ANDed together
+  //
+  if(c_filter_exprs.size()>0) {
+    c_filter_expr=CompileExprs(c_filter_exprs,"and","--filter");
+    if(cmd->debugActive()) {
+      fprintf(stderr,"lwmultcap: compiled filter expression:\n");
+      c_filter_expr->print(stderr);
+    }
+  }
 
   //
-  // Process Offsets
+  // Flight Recorder
   //
-  if(c_first_offset>0) {
-    data=data.right(data.size()-c_first_offset);
+  // Any one of several triggers will do
+  //
+  if(c_trigger_exprs.size()>0) {
+    c_trigger_expr=CompileExprs(c_trigger_exprs,"or","--trigger");
+    if(cmd->debugActive()) {
+      fprintf(stderr,"lwmultcap: compiled trigger expression:\n");
+      c_trigger_expr->print(stderr);
+    }
   }
-  if(c_last_offset>=0) {
-    data=data.left(c_last_offset);
+  if(c_mode==MainObject::ModeRecorder) {
+    c_recorder=new FlightRecorder(std::max(c_groups.size(),1),
+				  c_ring_packets,LWMULTCAP_MAX_PACKET_SIZE);
+    c_recorder->setMaxAge((uint64_t)c_ring_seconds*1000000000);
   }
-  
+
+  if(c_dup_window>0) {
+    c_dup_filter=new DupFilter((uint64_t)c_dup_window*1000000);
+  }
+  if((c_sample_interval>1)||(c_max_rate>0)) {
+    if((c_mode==MainObject::ModeStats)||(c_mode==MainObject::ModeRtp)) {
+      fprintf(stderr,"lwmultcap: \"--sample\" and \"--max-rate\" cannot be used in stats or rtp mode\n");
+      exit(1);
+    }
+    c_rate_limiter=new RateLimiter();
+    c_rate_limiter->setSampleInterval(c_sample_interval);
+    c_rate_limiter->setMaxRate(c_max_rate);
+  }
+
   //
-  // Process Filter Bytes
+  // Signals
   //
-  match=false;
-  for(QMap<unsigned,char>::const_iterator it=c_filter_bytes.begin();
-      it!=c_filter_bytes.end();it++) {
-    if((it.key()<(unsigned)data.size())&&(it.value()==data.at(it.key()))) {
-      match=true;
-      break;
-    }
+  // SIGINT and SIGTERM (and SIGUSR1, for the flight recorder) are
+  // blocked and delivered through a signalfd(2) so that they are
+  // serviced by the event loop, between batches. This has to happen
+  // before the pcapng writer thread is started, so that it inherits
+  // the mask.
+  //
+  sigset_t sigs;
+  sigemptyset(&sigs);
+  sigaddset(&sigs,SIGINT);
+  sigaddset(&sigs,SIGTERM);
+  if(c_mode==MainObject::ModeRecorder) {
+    sigaddset(&sigs,SIGUSR1);
   }
-  if((c_filter_bytes.size()>0)&&(!match)) {
-    return;
+  if(sigprocmask(SIG_BLOCK,&sigs,NULL)!=0) {
+    fprintf(stderr,"lwmultcap: unable to block signals [%s]\n",
+	    strerror(errno));
+    exit(1);
   }
+  if((c_signal_fd=signalfd(-1,&sigs,SFD_NONBLOCK|SFD_CLOEXEC))<0) {
+    fprintf(stderr,"lwmultcap: unable to create signalfd [%s]\n",
+	    strerror(errno));
+    exit(1);
+  }
+  c_signal_notifier=new QSocketNotifier(c_signal_fd,QSocketNotifier::Read,this);
+  connect(c_signal_notifier,SIGNAL(activated(int)),
+	  this,SLOT(signalData(int)));
 
   //
-  // Process Filter Strings
+  // Output
   //
-  match=false;
-  for(QMap<unsigned,QString>::const_iterator it=c_filter_strings.begin();
-      it!=c_filter_strings.end();it++) {
+  switch(c_mode) {
+  case MainObject::ModeHexdump:
+  case MainObject::ModeDelta:
+  case MainObject::ModeStats:
+  case MainObject::ModeAdvert:
+  case MainObject::ModeGpio:
+  case MainObject::ModeRecorder:
+  case MainObject::ModeRtp:
+    if((!c_output_filename.isEmpty())&&(c_output_filename!="-")) {
+      if((c_output_fd=open(c_output_filename.toUtf8().constData(),
+			   O_WRONLY|O_CREAT|O_TRUNC,0644))<0) {
+	fprintf(stderr,"lwmultcap: unable to open \"%s\" [%s]\n",
+		c_output_filename.toUtf8().constData(),strerror(errno));
+	exit(1);
+      }
+    }
+    if(c_mode==MainObject::ModeStats) {
+      c_source_stats=new SourceStats();
+    }
+    if(c_mode==MainObject::ModeRtp) {
+      c_rtp_stats=new RtpStats();
+    }
+    if(((c_mode==MainObject::ModeHexdump)||
+	(c_mode==MainObject::ModeRecorder))&&
+       (c_format!=MainObject::FormatText)) {
+      c_packet_formatter=new PacketFormatter();
+      c_packet_formatter->setEncoding(c_payload_encoding);
+      if(c_format==MainObject::FormatCsv) {
+	c_packet_formatter->formatCsvHeader(c_output);
+      }
+    }
+    if(((c_mode==MainObject::ModeHexdump)||(c_mode==MainObject::ModeDelta)||
+	(c_mode==MainObject::ModeRecorder))&&
+       (c_packet_formatter==NULL)&&c_show_timing) {
+      c_timing_stats=new SourceStats();
+    }
+    if(c_mode==MainObject::ModeDelta) {
+      c_delta_dump=new DeltaDump(c_hexdump);
+      c_delta_dump->setShowRuler(c_show_ruler);
+    }
+    if(c_mode==MainObject::ModeAdvert) {
+      c_adv_decoder=new AdvDecoder();
+      c_adv_decoder->setJson(c_format==MainObject::FormatJson);
+    }
+    if(c_mode==MainObject::ModeGpio) {
+      c_gpio_decoder=new GpioDecoder();
+      c_gpio_decoder->setJson(c_format==MainObject::FormatJson);
+      c_gpio_decoder->setTransitionsOnly(c_transitions_only);
+    }
+    break;
 
-    if((it.key()<(unsigned)data.size())&&
-       (it.value().toUtf8()==data.mid(it.key(),it.value().size()))) {
-      match=true;
-      break;
+  case MainObject::ModePcapng:
+    c_pcapng=new PcapngWriter(this);
+    if(!c_pcapng->open(c_output_filename,&err_msg)) {
+      fprintf(stderr,"lwmultcap: unable to open \"%s\" [%s]\n",
+	      c_output_filename.toUtf8().constData(),
+	      err_msg.toUtf8().constData());
+      exit(1);
     }
-  }
-  if((c_filter_strings.size()>0)&&(!match)) {
-    return;
+    break;
   }
 
   //
-  // Process Filter Addresses
+  // Hexdumps and advertisements on a pool of threads. Anything already
+  // in the buffer (a CSV header) has to go out first.
   //
-  match=false;
-  for(int i=0;i<c_filter_source_addresses.size();i++) {
-    if(c_filter_source_addresses.at(i)==src_addr) {
-      match=true;
-      break;
+  if(c_workers>0) {
+    c_output->flush(c_output_fd);
+    if(c_mode==MainObject::ModeAdvert) {
+      c_format_pool=new FormatPool(c_workers,c_output_fd,
+				   [this](OutputBuffer *out,const PacketView &pkt) {
+				     c_adv_decoder->format(out,pkt);
+				   });
+    }
+    else {
+      c_format_pool=new FormatPool(c_workers,c_output_fd,
+				   [this](OutputBuffer *out,const PacketView &pkt) {
+				     FormatPacket(out,pkt,HEXDUMP_NO_DELTA);
+				   });
     }
-  }
-  if((c_filter_source_addresses.size()>0)&&(!match)) {
-    return;
   }
 
-  PrintPacket(dst_addr,src_addr,src_port,data);
-  if(c_packet_limit>0) {
-    if(--c_packet_limit==0) {
-      exit(0);
+  //
+  // Offline Input
+  //
+  // Read in chunks from the event loop, like packets from the network
+  //
+  if(!c_read_filename.isEmpty()) {
+    std::string read_err;
+    c_reader=new CaptureReader();
+    if(!c_reader->open(c_read_filename.toStdString(),&read_err)) {
+      fprintf(stderr,"lwmultcap: unable to read \"%s\" [%s]\n",
+	      c_read_filename.toUtf8().constData(),read_err.c_str());
+      exit(1);
     }
+    if(c_pcapng!=NULL) {
+      c_pcapng->setBlocking(true);
+    }
+    c_read_timer=new QTimer(this);
+    c_read_timer->setSingleShot(true);
+    c_read_timer->setTimerType(Qt::PreciseTimer);
+    connect(c_read_timer,SIGNAL(timeout()),this,SLOT(readData()));
+    c_read_timer->start(0);
+    c_read_started=MonotonicNow();
+    StartTimers();
+    return;
   }
-}
-
 
-void MainObject::PrintPacket(const QHostAddress &dst_addr,
-			     const QHostAddress &src_addr,uint16_t src_port,
-			     const QByteArray &data)
-{
-  QString recv_from_str=
-    src_addr.toString()+QString::asprintf(":%d",0xFFFF&src_port);
-
-  QString recv_dst_str=dst_addr.toString()+QString::asprintf(":%d",0xFFFF&c_port);
-
-  QString size_str=QString::asprintf("0x%04X",data.size());
+  //
+  // Do as much filtering as we can in the kernel
+  //
+  BpfFilter *bpf=NULL;
+  if(c_kernel_filter) {
+    bpf=new BpfFilter();
+    std::string bpf_err;
+    bpf->setFirstOffset(c_first_offset);
+    bpf->setLastOffset(c_last_offset);
+    for(QMap<unsigned,char>::const_iterator it=c_filter_bytes.begin();
+	it!=c_filter_bytes.end();it++) {
+      bpf->addFilterByte(it.key(),0xFF&it.value());
+    }
+    for(QMap<unsigned,QByteArray>::const_iterator it=c_filter_strings.begin();
+	it!=c_filter_strings.end();it++) {
+      bpf->addFilterString(it.key(),it.value().constData(),it.value().size());
+    }
 
-  if(c_show_ruler) {
-    printf("------------------------------------------------------------------------------\n");
-    printf("| To: %-21s    From: %-21s     size: %-7s |\n",
-	   recv_dst_str.toUtf8().constData(),
-	   recv_from_str.toUtf8().constData(),
-	   size_str.toUtf8().constData());
-    printf("------------------------------------------------------------------------------\n");
-    printf("| Offset  0- 1- 2- 3- 4- 5- 6- 7- 8- 9- A- B- C- D- E- F- | 0123456789ABCDEF |\n");
-    printf("----------------------------------------------------------|------------------|\n");
-  }
-  for(int i=0;i<data.size();i+=16) {
-    QString str="";
-    printf("| 0x%04X: ",i);
-    for(int j=0;j<16;j++) {
-      if((i+j)<data.size()) {
-	char c=0xFF&data[i+j];
-	printf("%02X ",0xFF&c);
-	if((c>=' ')&&(c<='~')) {
-	  str+=c;
-	}
-	else {
-	  str+='.';
-	}
+    //
+    // Long address lists would make for a long program, so leave those
+    // to the hash lookup in userspace
+    //
+    if(c_filter_sources.size()<=LWMULTCAP_MAX_BPF_SOURCES) {
+      for(unsigned i=0;i<c_filter_sources.entries().size();i++) {
+	bpf->addFilterSourceAddress(c_filter_sources.entries().at(i).first,
+				    c_filter_sources.entries().at(i).second);
       }
-      else {
-	printf("   ");
-	str+=' ';
+    }
+    if(c_exclude_sources.size()<=LWMULTCAP_MAX_BPF_SOURCES) {
+      for(unsigned i=0;i<c_exclude_sources.entries().size();i++) {
+	bpf->addExcludeSourceAddress(c_exclude_sources.entries().at(i).first,
+				     c_exclude_sources.entries().at(i).second);
       }
     }
-    printf("| %s |\n",str.toUtf8().constData());
-  }
-  if(c_show_ruler) {
-    printf("------------------------------------------------------------------------------\n");
-  }
-}
-
+    if((!bpf->isEmpty())&&bpf->compile(&bpf_err)) {
+      c_kernel_filter_active=true;
+      c_kernel_filter_sources=
+	c_filter_sources.size()<=LWMULTCAP_MAX_BPF_SOURCES;
+      c_kernel_filter_excludes=
+	c_exclude_sources.size()<=LWMULTCAP_MAX_BPF_SOURCES;
+      if(cmd->debugActive()) {
+	fprintf(stderr,"lwmultcap: compiled kernel filter:\n");
+	bpf->print(stderr);
+      }
+    }
+    else {
+      if(cmd->debugActive()&&(!bpf->isEmpty())) {
+	fprintf(stderr,
+		"lwmultcap: using userspace filtering only [%s]\n",
+		bpf_err.c_str());
+      }
+      delete bpf;
+      bpf=NULL;
+    }
+  }
+
+  //
+  // Receive Sockets
+  //
+  // One per group, all served from a single epoll set
+  //
+  if((c_epoll_fd=epoll_create1(0))<0) {
+    fprintf(stderr,"lwmultcap: unable to create epoll set [%s]\n",
+	    strerror(errno));
+    exit(1);
+  }
+  for(int i=0;i<c_groups.size();i++) {
+    struct epoll_event ev;
+    c_groups[i].sock=OpenSocket(c_groups.at(i),bpf);
+    if(!Subscribe(c_groups.at(i).sock,c_groups.at(i).address,c_iface_address,
+		  &err_msg)) {
+      fprintf(stderr,"lwmultcap: unable to subscribe to %s [%s]\n",
+	      c_groups.at(i).address.toString().toUtf8().constData(),
+	      strerror(errno));
+      exit(1);
+    }
+    memset(&ev,0,sizeof(ev));
+    ev.events=EPOLLIN;
+    ev.data.u32=i;
+    if(epoll_ctl(c_epoll_fd,EPOLL_CTL_ADD,c_groups.at(i).sock,&ev)<0) {
+      fprintf(stderr,"lwmultcap: unable to add socket to epoll set [%s]\n",
+	      strerror(errno));
+      exit(1);
+    }
+  }
+  if(bpf!=NULL) {
+    delete bpf;
+  }
+
+  StartReceive();
+  StartTimers();
+}
+
+
+void MainObject::receiveData(int fd)
+{
+  ReceiveBatch();
+  FlushOutput();
+}
+
+
+void MainObject::readData()
+{
+  PacketView pkt;
+  uint64_t now;
+  uint64_t due;
+  struct timespec ts;
+  int g;
+
+  for(unsigned n=0;n<LWMULTCAP_READ_CHUNK;n++) {
+    if(c_read_pending) {
+      pkt=c_read_next;
+      c_read_pending=false;
+    }
+    else {
+      if(!c_reader->next(&pkt)) {
+	if(!c_reader->errorString().empty()) {
+	  fprintf(stderr,"lwmultcap: unable to read \"%s\" [%s]\n",
+		  c_read_filename.toUtf8().constData(),
+		  c_reader->errorString().c_str());
+	}
+	else if(c_reader->isTruncated()) {
+	  fprintf(stderr,"lwmultcap: \"%s\" is truncated or corrupt\n",
+		  c_read_filename.toUtf8().constData());
+	}
+	Finish();
+	return;
+      }
+
+      //
+      // Only the groups asked for, if any
+      //
+      if(c_groups.size()>0) {
+	for(g=0;g<c_groups.size();g++) {
+	  if((pkt.dstAddress()==c_groups.at(g).address.toIPv4Address())&&
+	     (pkt.dstPort()==c_groups.at(g).port)) {
+	    break;
+	  }
+	}
+	if(g==c_groups.size()) {
+	  continue;
+	}
+	pkt.setGroup(g);
+      }
+    }
+
+    //
+    // Hold the packet until it is due, relative to the first one. Longer
+    // waits go back to the event loop on a timer, which then leaves the
+    // last millisecond or so to clock_nanosleep(2) for precision.
+    //
+    if(c_read_paced&&(pkt.timestamp()!=0)) {
+      if(c_read_first_timestamp==0) {
+	c_read_first_timestamp=pkt.timestamp();
+      }
+      if(pkt.timestamp()>c_read_first_timestamp) {
+	due=c_read_started+(pkt.timestamp()-c_read_first_timestamp);
+	now=MonotonicNow();
+	if(due>(now+2000000)) {
+	  c_read_next=pkt;
+	  c_read_pending=true;
+	  FlushOutput();
+	  c_read_timer->start((due-now)/1000000-1);
+	  return;
+	}
+	if(due>now) {
+	  ts.tv_sec=due/1000000000;
+	  ts.tv_nsec=due%1000000000;
+	  while(clock_nanosleep(CLOCK_MONOTONIC,TIMER_ABSTIME,&ts,NULL)==EINTR);
+	}
+      }
+    }
+    ProcessPacket(pkt);
+    if(c_finished) {
+      return;
+    }
+  }
+  FlushOutput();
+  c_read_timer->start(0);
+}
+
+
+void MainObject::signalData(int fd)
+{
+  struct signalfd_siginfo info;
+
+  while(read(fd,&info,sizeof(info))==sizeof(info)) {
+    switch(info.ssi_signo) {
+    case SIGTERM:
+    case SIGINT:
+      if(c_epoll_fd>=0) {
+	ReceiveBatch();  // Drain anything already queued on the sockets
+      }
+      Finish();
+      return;
+
+    case SIGUSR1:
+      DumpRecorder(NULL);
+      c_output->flush(c_output_fd);
+      break;
+    }
+  }
+}
+
+
+void MainObject::durationData()
+{
+  if(c_epoll_fd>=0) {
+    ReceiveBatch();
+  }
+  Finish();
+}
+
+
+void MainObject::statsData()
+{
+  struct timespec ts;
+
+  if(c_source_stats!=NULL) {
+    RenderStats(MonotonicNow(),false);
+  }
+
+  //
+  // Close out a second even if nothing arrives after it, allowing a
+  // little time for packets stamped within it to be read
+  //
+  if(c_rtp_stats!=NULL) {
+    clock_gettime(CLOCK_REALTIME,&ts);
+    c_rtp_stats->advance(c_output,(uint64_t)ts.tv_sec*1000000000+ts.tv_nsec-
+			 (uint64_t)LWMULTCAP_RTP_SETTLE_TIME*1000000);
+  }
+  c_output->flush(c_output_fd);
+}
+
+
+void MainObject::reportData()
+{
+  ReportCounts();
+}
+
+
+void MainObject::dupReportData()
+{
+  ReportDuplicates();
+}
+
+
+void MainObject::flushData()
+{
+  c_pcapng->poll();
+}
+
+
+void MainObject::StartReceive()
+{
+  char *data;
+  char *cmsgs;
+
+  //
+  // Preallocate the receive slots, 'c_batch_size' for each group
+  //
+  c_total_slots=c_batch_size*c_groups.size();
+  c_msgs=new struct mmsghdr[c_total_slots];
+  c_iovs=new struct iovec[c_total_slots];
+  c_names=new struct sockaddr_in[c_total_slots];
+  data=new char[c_total_slots*LWMULTCAP_MAX_PACKET_SIZE];
+  cmsgs=new char[c_total_slots*LWMULTCAP_CMSG_SIZE];
+  c_pkts=new PacketView[c_total_slots];
+  c_order=new unsigned[c_total_slots];
+  memset(c_msgs,0,c_total_slots*sizeof(struct mmsghdr));
+  memset(c_iovs,0,c_total_slots*sizeof(struct iovec));
+  memset(c_names,0,c_total_slots*sizeof(struct sockaddr_in));
+  memset(cmsgs,0,c_total_slots*LWMULTCAP_CMSG_SIZE);
+  for(unsigned i=0;i<c_total_slots;i++) {
+    c_iovs[i].iov_base=data+i*LWMULTCAP_MAX_PACKET_SIZE;
+    c_iovs[i].iov_len=LWMULTCAP_MAX_PACKET_SIZE;
+    c_msgs[i].msg_hdr.msg_name=c_names+i;
+    c_msgs[i].msg_hdr.msg_iov=c_iovs+i;
+    c_msgs[i].msg_hdr.msg_iovlen=1;
+    c_msgs[i].msg_hdr.msg_control=cmsgs+i*LWMULTCAP_CMSG_SIZE;
+  }
+
+  //
+  // The epoll set is itself readable whenever any of its sockets is,
+  // so one notifier covers every group
+  //
+  c_epoll_notifier=new QSocketNotifier(c_epoll_fd,QSocketNotifier::Read,this);
+  connect(c_epoll_notifier,SIGNAL(activated(int)),
+	  this,SLOT(receiveData(int)));
+}
+
+
+void MainObject::StartTimers()
+{
+  if(c_duration>0) {
+    c_duration_timer=new QTimer(this);
+    c_duration_timer->setSingleShot(true);
+    connect(c_duration_timer,SIGNAL(timeout()),this,SLOT(durationData()));
+    c_duration_timer->start(1000*c_duration);
+  }
+  //
+  // With --read-file, intervals are cut on capture timestamps instead
+  //
+  if(((c_source_stats!=NULL)||(c_rtp_stats!=NULL))&&(c_reader==NULL)) {
+    c_stats_timer=new QTimer(this);
+    connect(c_stats_timer,SIGNAL(timeout()),this,SLOT(statsData()));
+    c_stats_timer->start(SOURCESTATS_INTERVAL);
+    c_source_stats_rendered=MonotonicNow();
+  }
+  if(c_report_interval>0) {
+    c_report_timer=new QTimer(this);
+    connect(c_report_timer,SIGNAL(timeout()),this,SLOT(reportData()));
+    c_report_timer->start(1000*c_report_interval);
+  }
+  if(c_dup_filter!=NULL) {
+    c_dup_report_timer=new QTimer(this);
+    connect(c_dup_report_timer,SIGNAL(timeout()),this,SLOT(dupReportData()));
+    c_dup_report_timer->start(DUPFILTER_REPORT_INTERVAL);
+  }
+  if(c_pcapng!=NULL) {
+    c_flush_timer=new QTimer(this);
+    connect(c_flush_timer,SIGNAL(timeout()),this,SLOT(flushData()));
+    c_flush_timer->start(PCAPNGWRITER_FLUSH_INTERVAL);
+  }
+}
+
+
+void MainObject::ReceiveBatch()
+{
+  struct epoll_event events[LWMULTCAP_MAX_GROUPS];
+  unsigned count=0;
+  int ready;
+  int n;
+
+  if((ready=epoll_wait(c_epoll_fd,events,c_groups.size(),0))<0) {
+    if(errno==EINTR) {
+      return;
+    }
+    fprintf(stderr,"lwmultcap: epoll error [%s]\n",strerror(errno));
+    exit(1);
+  }
+
+  //
+  // Drain a batch from each ready socket
+  //
+  for(int e=0;e<ready;e++) {
+    unsigned g=events[e].data.u32;
+    struct mmsghdr *gmsgs=c_msgs+g*c_batch_size;
+    for(unsigned i=0;i<c_batch_size;i++) {
+      gmsgs[i].msg_hdr.msg_namelen=sizeof(struct sockaddr_in);
+      gmsgs[i].msg_hdr.msg_controllen=LWMULTCAP_CMSG_SIZE;
+    }
+    if((n=recvmmsg(c_groups.at(g).sock,gmsgs,c_batch_size,MSG_DONTWAIT,
+		   NULL))<0) {
+      if((errno==EINTR)||(errno==EAGAIN)) {
+	continue;
+      }
+      fprintf(stderr,"lwmultcap: socket error [%s]\n",strerror(errno));
+      exit(1);
+    }
+    c_batch_calls++;
+    c_batch_packets+=n;
+    if((unsigned)n==c_batch_size) {
+      c_batch_full++;
+    }
+    for(int i=0;i<n;i++) {
+      unsigned slot=g*c_batch_size+i;
+      struct msghdr *msg=&c_msgs[slot].msg_hdr;
+      PacketView *pkt=c_pkts+count;
+      if(msg->msg_flags!=0) {
+	fprintf(stderr,"lwmultcap: error flags received!\n");
+	exit(1);
+      }
+      *pkt=PacketView((const char *)c_iovs[slot].iov_base,
+		      c_msgs[slot].msg_len);
+      pkt->setSource(ntohl(c_names[slot].sin_addr.s_addr),
+		     ntohs(c_names[slot].sin_port));
+      pkt->setDestination(c_groups.at(g).address.toIPv4Address(),
+			  c_groups.at(g).port);
+      pkt->setGroup(g);
+
+      struct cmsghdr *cmsg;
+      cmsg=CMSG_FIRSTHDR(msg);
+      while(cmsg!=NULL) {
+	if((cmsg->cmsg_level==IPPROTO_IP)&&(cmsg->cmsg_type==IP_PKTINFO)) {
+	  struct in_pktinfo pktinfo;
+	  memcpy(&pktinfo,CMSG_DATA(cmsg),sizeof(pktinfo));
+	  pkt->setDestination(ntohl(pktinfo.ipi_addr.s_addr),
+			      c_groups.at(g).port);
+	}
+	if((cmsg->cmsg_level==SOL_SOCKET)&&
+	   (cmsg->cmsg_type==SCM_TIMESTAMPNS)) {
+	  struct timespec ts;
+	  memcpy(&ts,CMSG_DATA(cmsg),sizeof(ts));
+	  pkt->setTimestamp((uint64_t)ts.tv_sec*1000000000+ts.tv_nsec);
+	}
+	cmsg=CMSG_NXTHDR(msg,cmsg);
+      }
+      c_order[count]=count;
+      count++;
+    }
+  }
+
+  //
+  // Each socket's batch is already in arrival order, so only the merge
+  // across sockets needs the kernel timestamps. Ties keep the order in
+  // which we read them.
+  //
+  if(ready>1) {
+    PacketView *pkts=c_pkts;
+    std::sort(c_order,c_order+count,[pkts](unsigned a,unsigned b) {
+	if(pkts[a].timestamp()!=pkts[b].timestamp()) {
+	  return pkts[a].timestamp()<pkts[b].timestamp();
+	}
+	return a<b;
+      });
+  }
+  for(unsigned i=0;(i<count)&&(!c_finished);i++) {
+    ProcessPacket(c_pkts[c_order[i]]);
+  }
+}
+
+
+void MainObject::ProcessPacket(PacketView data)
+{
+  const PacketView packet=data;
+
+  c_report_received++;
+
+  //
+  // Process Offsets
+  //
+  if(c_first_offset>0) {
+    data.chopFront(c_first_offset);
+  }
+  if(c_last_offset>=0) {
+    data.truncate(c_last_offset);
+  }
+  
+  if(!MatchesKernelFilters(data)) {
+    if(c_kernel_filter_active) {
+      c_kernel_filter_mismatches++;
+    }
+    return;
+  }
+  if(!MatchesUserFilters(data)) {
+    return;
+  }
+  if((c_dup_filter!=NULL)&&c_dup_filter->isDuplicate(packet)) {
+    return;
+  }
+  if((c_rate_limiter!=NULL)&&(!c_rate_limiter->admit(packet.timestamp()))) {
+    return;
+  }
+  c_report_output++;
+
+  switch(c_mode) {
+  case MainObject::ModeHexdump:
+    if(c_format_pool!=NULL) {
+      c_format_pool->submit(data);
+    }
+    else {
+      PrintPacket(data);
+    }
+    break;
+
+  case MainObject::ModeDelta:
+    PrintPacket(data);
+    break;
+
+  case MainObject::ModePcapng:
+    c_pcapng->writePacket(packet);  // Always the whole payload
+    break;
+
+  case MainObject::ModeStats:
+    if(c_reader!=NULL) {
+      AdvanceStats(data.timestamp());
+    }
+    c_source_stats->update(data.srcAddress(),data.srcPort(),packet.size(),
+			   data.timestamp());
+    break;
+
+  case MainObject::ModeAdvert:
+    if(c_format_pool!=NULL) {
+      if(c_adv_decoder->accept(c_output,packet)) {
+	//
+	// The column headings, if just printed, go out ahead of anything
+	// from the pool
+	//
+	c_output->flush(c_output_fd);
+	c_format_pool->submit(packet);
+      }
+    }
+    else {
+      c_adv_decoder->decode(c_output,packet);
+    }
+    break;
+
+  case MainObject::ModeGpio:
+    c_gpio_decoder->decode(c_output,packet);
+    break;
+
+  case MainObject::ModeRecorder:
+    RecordPacket(data);
+    break;
+
+  case MainObject::ModeRtp:
+    c_rtp_stats->update(c_output,packet);
+    break;
+  }
+  if(c_packet_limit>0) {
+    if(--c_packet_limit==0) {
+      Finish();
+    }
+  }
+}
+
+
+//
+// The filters that can be compiled into the kernel filter. A packet that
+// fails one of these after passing the kernel filter means that the two
+// disagree.
+//
+bool MainObject::MatchesKernelFilters(const PacketView &data) const
+{
+  bool match=false;
+
+  //
+  // Process Filter Bytes
+  //
+  for(QMap<unsigned,char>::const_iterator it=c_filter_bytes.begin();
+      it!=c_filter_bytes.end();it++) {
+    if((it.key()<(unsigned)data.size())&&(it.value()==data.at(it.key()))) {
+      match=true;
+      break;
+    }
+  }
+  if((c_filter_bytes.size()>0)&&(!match)) {
+    return false;
+  }
+
+  //
+  // Process Filter Strings
+  //
+  match=false;
+  for(QMap<unsigned,QByteArray>::const_iterator it=c_filter_strings.begin();
+      it!=c_filter_strings.end();it++) {
+    if(data.matches(it.key(),it.value().constData(),it.value().size())) {
+      match=true;
+      break;
+    }
+  }
+  if((c_filter_strings.size()>0)&&(!match)) {
+    return false;
+  }
+
+  //
+  // Process Filter Addresses
+  //
+  if(c_kernel_filter_sources&&(!MatchesSources(data))) {
+    return false;
+  }
+  if(c_kernel_filter_excludes&&(!MatchesExcludes(data))) {
+    return false;
+  }
+
+  return true;
+}
+
+
+bool MainObject::MatchesUserFilters(const PacketView &data) const
+{
+  //
+  // Process Filter Addresses left out of the kernel filter
+  //
+  if((!c_kernel_filter_sources)&&(!MatchesSources(data))) {
+    return false;
+  }
+  if((!c_kernel_filter_excludes)&&(!MatchesExcludes(data))) {
+    return false;
+  }
+
+  //
+  // Process Filter Expression
+  //
+  if((c_filter_expr!=NULL)&&(!c_filter_expr->matches(data))) {
+    return false;
+  }
+
+  return true;
+}
+
+
+bool MainObject::MatchesSources(const PacketView &data) const
+{
+  return c_filter_sources.isEmpty()||
+    c_filter_sources.contains(data.srcAddress());
+}
+
+
+bool MainObject::MatchesExcludes(const PacketView &data) const
+{
+  return c_exclude_sources.isEmpty()||
+    (!c_exclude_sources.contains(data.srcAddress()));
+}
+
+
+void MainObject::PrintPacket(const PacketView &data)
+{
+  int64_t delta=HEXDUMP_NO_DELTA;
+
+  if(c_timing_stats!=NULL) {
+    c_timing_stats->update(data.srcAddress(),data.srcPort(),data.size(),
+			   data.timestamp(),&delta);
+  }
+  FormatPacket(c_output,data,delta);
+}
+
+
+//
+// Called on the format pool threads as well, so must change nothing
+//
+void MainObject::FormatPacket(OutputBuffer *out,const PacketView &data,
+			      int64_t delta) const
+{
+  char str[40];
+
+  if(c_packet_formatter!=NULL) {
+    if(c_format==MainObject::FormatCsv) {
+      c_packet_formatter->formatCsv(out,data);
+    }
+    else {
+      c_packet_formatter->formatJson(out,data);
+    }
+    return;
+  }
+
+  //
+  // The ruler already names the group and gives the timing; without it,
+  // say which group this came from when there is more than one, and
+  // when it arrived if asked
+  //
+  if(!c_show_ruler) {
+    if(c_groups.size()>1) {
+      HexDump::formatAddress(str,data.dstAddress(),data.dstPort());
+      out->appendf("[%s]",str);
+      if(!c_show_timing) {
+	out->append('\n');
+      }
+    }
+    if(c_show_timing) {
+      if(c_groups.size()>1) {
+	out->append(' ');
+      }
+      HexDump::formatTime(str,data.timestamp());
+      out->appendf("[%s ",str);
+      HexDump::formatDelta(str,delta);
+      out->appendf("%s]\n",str);
+    }
+  }
+  if(c_delta_dump!=NULL) {
+    c_delta_dump->format(out,data,delta);
+    return;
+  }
+  c_hexdump->formatPacket(out,data.dstAddress(),data.dstPort(),
+			  data.srcAddress(),data.srcPort(),
+			  data.data(),data.size(),data.timestamp(),delta);
+}
+
+
+void MainObject::FlushOutput()
+{
+  if(c_format_pool!=NULL) {
+    c_format_pool->flush();
+  }
+  c_output->flush(c_output_fd);
+}
+
+
+void MainObject::RecordPacket(const PacketView &data)
+{
+  //
+  // Packets after a trigger go straight out, until we have enough
+  //
+  if(c_post_trigger_remaining>0) {
+    PrintPacket(data);
+    if((--c_post_trigger_remaining==0)&&(c_packet_formatter==NULL)) {
+      c_output->appendf("*** End of dump, %u packet(s) after the trigger ***\n\n",
+			c_post_trigger);
+    }
+    return;
+  }
+  c_recorder->record(data);
+  if((c_trigger_expr!=NULL)&&c_trigger_expr->matches(data)) {
+    DumpRecorder(&data);
+  }
+}
+
+
+//
+// Print everything in the rings, then arrange for the next
+// 'c_post_trigger' packets to follow. 'trigger' is the packet that
+// matched the trigger expression, or NULL for SIGUSR1.
+//
+void MainObject::DumpRecorder(const PacketView *trigger)
+{
+  std::vector<PacketView> pkts;
+  char str[40];
+
+  if(c_post_trigger_remaining>0) {
+    return;  // Still finishing the last one
+  }
+  c_recorder->collect(&pkts);
+  if(c_packet_formatter==NULL) {
+    if(trigger==NULL) {
+      c_output->appendf("*** Triggered by SIGUSR1, %u packet(s) recorded ***\n",
+			(unsigned)pkts.size());
+    }
+    else {
+      HexDump::formatTime(str,trigger->timestamp());
+      c_output->appendf("*** Triggered at %s, %u packet(s) recorded ***\n",
+			str,(unsigned)pkts.size());
+    }
+  }
+  for(unsigned i=0;i<pkts.size();i++) {
+    PrintPacket(pkts.at(i));
+  }
+  c_recorder->clear();
+  c_recorder_dumps++;
+  c_post_trigger_remaining=c_post_trigger;
+  if((c_post_trigger==0)&&(c_packet_formatter==NULL)) {
+    c_output->append("*** End of dump ***\n\n");
+  }
+}
+
+
+void MainObject::PrintStats() const
+{
+  if((c_adv_decoder!=NULL)&&(c_adv_decoder->packetsSkipped()>0)) {
+    fprintf(stderr,"lwmultcap: %lu packets were not advertisements\n",
+	    (unsigned long)c_adv_decoder->packetsSkipped());
+  }
+  if((c_gpio_decoder!=NULL)&&(c_gpio_decoder->packetsSkipped()>0)) {
+    fprintf(stderr,"lwmultcap: %lu packets were not GPIO messages\n",
+	    (unsigned long)c_gpio_decoder->packetsSkipped());
+  }
+  if(c_rate_limiter!=NULL) {
+    fprintf(stderr,"lwmultcap: %lu packets matched, %lu output\n",
+	    (unsigned long)c_rate_limiter->packetsSeen(),
+	    (unsigned long)c_rate_limiter->packetsAdmitted());
+  }
+  if(c_dup_filter!=NULL) {
+    fprintf(stderr,"lwmultcap: %lu duplicate packets suppressed\n",
+	    (unsigned long)c_dup_filter->suppressed());
+  }
+  if(c_rtp_stats!=NULL) {
+    if(c_rtp_stats->packetsSkipped()>0) {
+      fprintf(stderr,"lwmultcap: %lu packets were not RTP\n",
+	      (unsigned long)c_rtp_stats->packetsSkipped());
+    }
+    if(c_rtp_stats->packetsUntracked()>0) {
+      fprintf(stderr,
+	      "lwmultcap: %lu packets were from streams beyond the first %u, and were not tracked\n",
+	      (unsigned long)c_rtp_stats->packetsUntracked(),
+	      RTPSTATS_MAX_STREAMS);
+    }
+  }
+  if(c_recorder!=NULL) {
+    fprintf(stderr,"lwmultcap: %lu flight recorder dumps triggered\n",
+	    (unsigned long)c_recorder_dumps);
+  }
+  if((c_delta_dump!=NULL)&&(c_delta_dump->packetsUnchanged()>0)) {
+    fprintf(stderr,"lwmultcap: %lu packets were unchanged\n",
+	    (unsigned long)c_delta_dump->packetsUnchanged());
+  }
+  if(c_pcapng!=NULL) {
+    fprintf(stderr,"lwmultcap: %lu packets written",
+	    (unsigned long)c_pcapng->packetsWritten());
+    if(c_pcapng->packetsDropped()>0) {
+      fprintf(stderr,", %lu dropped because the writer fell behind",
+	      (unsigned long)c_pcapng->packetsDropped());
+    }
+    fprintf(stderr,"\n");
+  }
+  if(c_kernel_filter_active&&(c_kernel_filter_mismatches>0)) {
+    fprintf(stderr,
+	    "lwmultcap: %lu packets passed the kernel filter but failed the userspace filter\n",
+	    (unsigned long)c_kernel_filter_mismatches);
+  }
+  if(!c_show_batch_stats) {
+    return;
+  }
+  if(c_reader!=NULL) {
+    fprintf(stderr,"lwmultcap: read %lu packets (%lu not UDP/IPv4) in %.3f s",
+	    (unsigned long)c_reader->packetsRead(),
+	    (unsigned long)c_reader->packetsSkipped(),
+	    (double)c_read_elapsed/1e9);
+    if(c_read_elapsed>0) {
+      fprintf(stderr,", %.0f packets/sec",
+	      1e9*(double)c_reader->packetsRead()/(double)c_read_elapsed);
+    }
+    fprintf(stderr,"\n");
+    return;
+  }
+  fprintf(stderr,"lwmultcap: %lu packets received in %lu recvmmsg() calls\n",
+	  (unsigned long)c_batch_packets,(unsigned long)c_batch_calls);
+  if(c_batch_calls>0) {
+    fprintf(stderr,
+	    "lwmultcap: mean batch fill %.2f of %u (%.1f%%), %lu full batches\n",
+	    (double)c_batch_packets/(double)c_batch_calls,c_batch_size,
+	    100.0*(double)c_batch_packets/
+	    ((double)c_batch_calls*(double)c_batch_size),
+	    (unsigned long)c_batch_full);
+  }
+}
+
+
+int MainObject::OpenSocket(const Group &group,const BpfFilter *bpf) const
+{
+  int sock;
+  unsigned optval=1;
+  std::string bpf_err;
+
+  if((sock=socket(AF_INET,SOCK_DGRAM,0))<0) {
+    fprintf(stderr,"lwmultcap: unable to create socket [%s]\n",strerror(errno));
+    exit(1);
+  }
+
+  //
+  // So we can get the actual delivery address and arrival time
+  //
+  if(setsockopt(sock,IPPROTO_IP,IP_PKTINFO,&optval,sizeof(optval))!=0) {
+    fprintf(stderr,"lwmultcap: unable to set IP_PKTINFO [%s] on socket\n",
+	    strerror(errno));
+    exit(1);
+  }
+  if(setsockopt(sock,SOL_SOCKET,SO_TIMESTAMPNS,&optval,sizeof(optval))!=0) {
+    fprintf(stderr,"lwmultcap: unable to set SO_TIMESTAMPNS [%s] on socket\n",
+	    strerror(errno));
+    exit(1);
+  }
+
+  //
+  // Several groups may share a port, and other programs may be listening
+  // too. Binding to the group address and turning off IP_MULTICAST_ALL
+  // keeps each socket to just its own group's traffic.
+  //
+  if(setsockopt(sock,SOL_SOCKET,SO_REUSEADDR,&optval,sizeof(optval))!=0) {
+    fprintf(stderr,"lwmultcap: unable to set SO_REUSEADDR [%s] on socket\n",
+	    strerror(errno));
+    exit(1);
+  }
+  optval=0;
+  if(setsockopt(sock,IPPROTO_IP,IP_MULTICAST_ALL,&optval,sizeof(optval))!=0) {
+    fprintf(stderr,
+	    "lwmultcap: unable to clear IP_MULTICAST_ALL [%s] on socket\n",
+	    strerror(errno));
+    exit(1);
+  }
+
+  if((bpf!=NULL)&&(!bpf->attach(sock,&bpf_err))) {
+    fprintf(stderr,"lwmultcap: unable to attach kernel filter [%s]\n",
+	    bpf_err.c_str());
+    exit(1);
+  }
+
+  sockaddr_in sa;
+  memset(&sa,0,sizeof(sa));
+  sa.sin_family=AF_INET;
+  sa.sin_port=htons(group.port);
+  sa.sin_addr.s_addr=htonl(group.address.toIPv4Address());
+  if(bind(sock,(struct sockaddr *)(&sa),sizeof(sa))<0) {
+    fprintf(stderr,"lwmultcap: unable to bind socket [%s]\n",strerror(errno));
+    exit(1);
+  }
+
+  return sock;
+}
+
+
+//
+// Print a table for each interval of capture time that ends before
+// 'timestamp'. An interval with no packets at all is folded into the
+// next one.
+//
+void MainObject::AdvanceStats(uint64_t timestamp)
+{
+  uint64_t interval=(uint64_t)SOURCESTATS_INTERVAL*1000000;
+
+  if(timestamp==0) {
+    return;  // No timestamp recorded
+  }
+  if(c_source_stats_rendered==0) {
+    c_source_stats_rendered=timestamp;
+  }
+  if(timestamp>=(c_source_stats_rendered+interval)) {
+    RenderStats(c_source_stats_rendered+
+		interval*((timestamp-c_source_stats_rendered)/interval),false);
+  }
+  if(timestamp>c_source_stats_last) {
+    c_source_stats_last=timestamp;
+  }
+}
+
+
+void MainObject::RenderStats(uint64_t now,bool final)
+{
+  //
+  // Redraw in place on a terminal, but leave the final table below
+  // everything else. Tables from a file come too fast to read that
+  // way, so print them one after another.
+  //
+  c_source_stats->render(c_output,now-c_source_stats_rendered,
+			 isatty(c_output_fd)&&(!final)&&(c_reader==NULL));
+  c_source_stats_rendered=now;
+}
+
+
+void MainObject::ReportDuplicates()
+{
+  if(c_dup_filter->intervalSuppressed()>0) {
+    fprintf(stderr,
+	    "lwmultcap: %lu duplicate packets suppressed in the last %u seconds\n",
+	    (unsigned long)c_dup_filter->intervalSuppressed(),
+	    DUPFILTER_REPORT_INTERVAL/1000);
+    c_dup_filter->resetInterval();
+  }
+}
+
+
+void MainObject::ReportCounts()
+{
+  fprintf(stderr,
+	  "lwmultcap: %lu packets received, %lu output in the last %u seconds\n",
+	  (unsigned long)c_report_received,(unsigned long)c_report_output,
+	  c_report_interval);
+  c_report_received=0;
+  c_report_output=0;
+}
+
+
+//
+// Wind everything up and leave the event loop. Called at most once,
+// for the end of the input, the packet limit, the duration or a signal.
+//
+void MainObject::Finish()
+{
+  if(c_finished) {
+    return;
+  }
+  c_finished=true;
+  if(c_format_pool!=NULL) {
+    c_format_pool->finish();
+    if(c_format_pool->writeError()) {
+      fprintf(stderr,"lwmultcap: error writing output\n");
+    }
+  }
+  if(c_reader!=NULL) {
+    c_read_elapsed=MonotonicNow()-c_read_started;
+    c_read_timer->stop();
+  }
+  if(c_epoll_notifier!=NULL) {
+    c_epoll_notifier->setEnabled(false);
+  }
+  c_signal_notifier->setEnabled(false);
+  if(c_duration_timer!=NULL) {
+    c_duration_timer->stop();
+  }
+  if(c_stats_timer!=NULL) {
+    c_stats_timer->stop();
+  }
+  if(c_report_timer!=NULL) {
+    c_report_timer->stop();
+  }
+  if(c_dup_report_timer!=NULL) {
+    c_dup_report_timer->stop();
+  }
+  if(c_flush_timer!=NULL) {
+    c_flush_timer->stop();
+  }
+
+  if(c_source_stats!=NULL) {
+    if(c_reader!=NULL) {
+      RenderStats(c_source_stats_last,true);
+    }
+    else {
+      RenderStats(MonotonicNow(),true);
+    }
+  }
+  if(c_rtp_stats!=NULL) {
+    c_rtp_stats->renderTotals(c_output);
+  }
+  if((c_post_trigger_remaining>0)&&(c_packet_formatter==NULL)) {
+    c_output->appendf("*** End of dump, %u packet(s) after the trigger ***\n\n",
+		      c_post_trigger-c_post_trigger_remaining);
+  }
+  if(c_timing_stats!=NULL) {
+    c_output->append('\n');
+    c_timing_stats->renderTiming(c_output);
+  }
+  c_output->flush(c_output_fd);
+  if(c_pcapng!=NULL) {
+    c_pcapng->close();
+    if(c_pcapng->writeError()) {
+      fprintf(stderr,"lwmultcap: error writing pcapng data\n");
+    }
+  }
+  PrintStats();
+  QCoreApplication::exit(0);
+}
+
 
 bool MainObject::Subscribe(int sock,const QHostAddress &addr,
-			   const QHostAddress &if_addr,QString *err_msg)
+			   const QHostAddress &if_addr,QString *err_msg) const
 {
   struct ip_mreqn mreq;
 
@@ -430,6 +1811,66 @@ unsigned MainObject::ReadIntegerArg(const QString &arg,bool *ok) const
 }
 
 
+//
+// Parse an IPv4 address with an optional CIDR prefix length, as
+// 'addr[/len]'
+//
+bool MainObject::ReadNetworkArg(const QString &arg,uint32_t *addr,
+				unsigned *prefix_len) const
+{
+  QStringList f0=arg.split("/",Qt::KeepEmptyParts);
+  QHostAddress host;
+  bool ok=true;
+
+  if((f0.size()>2)||(!host.setAddress(f0.at(0)))) {
+    return false;
+  }
+  *addr=host.toIPv4Address();
+  *prefix_len=32;
+  if(f0.size()==2) {
+    *prefix_len=f0.at(1).toUInt(&ok);
+    if((!ok)||(*prefix_len>32)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+//
+// Compile one or more expressions, joined by 'conj', exiting with an
+// error naming 'sw' if any is bad
+//
+FilterExpr *MainObject::CompileExprs(const QStringList &exprs,
+				     const QString &conj,
+				     const QString &sw) const
+{
+  FilterExpr *expr=new FilterExpr();
+  std::string expr_err;
+
+  if(!expr->compile(("("+exprs.join(") "+conj+" (")+")").toStdString(),
+		    &expr_err)) {
+    //
+    // Say which one was bad, with the column relative to it
+    //
+    for(int i=0;i<exprs.size();i++) {
+      if(!expr->compile(exprs.at(i).toStdString(),&expr_err)) {
+	fprintf(stderr,"lwmultcap: invalid \"%s\" expression \"%s\": %s\n",
+		sw.toUtf8().constData(),exprs.at(i).toUtf8().constData(),
+		expr_err.c_str());
+	exit(1);
+      }
+    }
+    fprintf(stderr,"lwmultcap: invalid \"%s\" expression\n",
+	    sw.toUtf8().constData());
+    exit(1);
+  }
+
+  return expr;
+}
+
+
 int main(int argc,char *argv[])
 {
   QCoreApplication a(argc,argv);
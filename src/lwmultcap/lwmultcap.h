@@ -21,13 +21,45 @@
 #ifndef LWMULTCAP_H
 #define LWMULTCAP_H
 
+#include <netinet/in.h>
 #include <stdint.h>
+#include <sys/socket.h>
 
 #include <QByteArray>
 #include <QHostAddress>
 #include <QObject>
+#include <QSocketNotifier>
+#include <QTimer>
 
-#define LWMULTCAP_USAGE "--iface-address=<iface-addr> --mcast-address=<mcast-addr> --port=<port-num> [--show-ruler] [--no-ruler] [--first-offset=<offset>] [--last-offset=<offset>] [--filter-byte=<offset>:<value>] [--filter-string=<offset>:<string>\n\n"
+#include "addressset.h"
+#include "advdecoder.h"
+#include "bpffilter.h"
+#include "capturereader.h"
+#include "deltadump.h"
+#include "dupfilter.h"
+#include "filterexpr.h"
+#include "flightrecorder.h"
+#include "formatpool.h"
+#include "gpiodecoder.h"
+#include "hexdump.h"
+#include "outputbuffer.h"
+#include "packetformatter.h"
+#include "packetview.h"
+#include "pcapngwriter.h"
+#include "ratelimiter.h"
+#include "rtpstats.h"
+#include "sourcestats.h"
+
+#define LWMULTCAP_USAGE "--iface-address=<iface-addr>|--read-file=<filename> --mcast-address=<mcast-addr>[:<port-num>] [--mcast-address=<mcast-addr>[:<port-num>]]... [--port=<port-num>] [--mode=hexdump|delta|pcapng|stats|advert|gpio|recorder|rtp] [--ring-packets=<count>] [--ring-seconds=<secs>] [--trigger=<expr>] [--post-trigger=<count>] [--format=text|json|csv] [--payload-encoding=hex|base64] [--transitions-only] [--timing] [--dedupe=<msecs>] [--sample=<count>] [--max-rate=<pps>] [--paced] [--duration=<secs>] [--packet-limit=<count>] [--report-interval=<secs>] [--workers=<count>] [--output-file=<filename>] [--batch=<count>] [--no-kernel-filter] [--show-ruler] [--no-ruler] [--first-offset=<offset>] [--last-offset=<offset>] [--filter=<expr>] [--filter-byte=<offset>:<value>] [--filter-string=<offset>:<string>] [--filter-source-address=<addr>[/<len>]] [--exclude-source-address=<addr>[/<len>]]\n\n"
+
+#define LWMULTCAP_MAX_PACKET_SIZE 1500
+#define LWMULTCAP_CMSG_SIZE 256
+#define LWMULTCAP_DEFAULT_BATCH_SIZE 32
+#define LWMULTCAP_MAX_BATCH_SIZE 1024
+#define LWMULTCAP_MAX_GROUPS 64
+#define LWMULTCAP_MAX_BPF_SOURCES 64
+#define LWMULTCAP_READ_CHUNK 1024  // Packets
+#define LWMULTCAP_RTP_SETTLE_TIME 100  // mS
 
 class MainObject : public QObject
 {
@@ -35,29 +67,139 @@ class MainObject : public QObject
  public:
   MainObject(QObject *parent=0);
 
- protected:
-  
+ private slots:
+  void receiveData(int fd);
+  void readData();
+  void signalData(int fd);
+  void durationData();
+  void statsData();
+  void reportData();
+  void dupReportData();
+  void flushData();
+
  private:
-  void MainLoop(int sock);
-  void ProcessPacket(const QHostAddress &dst_addr,
-		     const QHostAddress &src_addr,uint16_t src_port,
-		     QByteArray data);
-  void PrintPacket(const QHostAddress &dst_addr,
-		   const QHostAddress &src_addr,uint16_t src_port,
-		   const QByteArray &data);
+  enum Mode {ModeHexdump=0,ModePcapng=1,ModeStats=2,ModeAdvert=3,
+	    ModeGpio=4,ModeDelta=5,ModeRecorder=6,ModeRtp=7};
+  enum Format {FormatText=0,FormatJson=1,FormatCsv=2};
+  struct Group {
+    QHostAddress address;
+    uint16_t port;
+    int sock;
+  };
+  void StartReceive();
+  void ReceiveBatch();
+  void StartTimers();
+  void ProcessPacket(PacketView data);
+  void PrintPacket(const PacketView &data);
+  void FormatPacket(OutputBuffer *out,const PacketView &data,
+		    int64_t delta) const;
+  void FlushOutput();
+  void RecordPacket(const PacketView &data);
+  void DumpRecorder(const PacketView *trigger);
+  bool MatchesKernelFilters(const PacketView &data) const;
+  bool MatchesUserFilters(const PacketView &data) const;
+  bool MatchesSources(const PacketView &data) const;
+  bool MatchesExcludes(const PacketView &data) const;
+  void PrintStats() const;
+  void AdvanceStats(uint64_t timestamp);
+  void RenderStats(uint64_t now,bool final);
+  void ReportDuplicates();
+  void ReportCounts();
+  void Finish();
+  int OpenSocket(const Group &group,const BpfFilter *bpf) const;
   bool Subscribe(int sock,const QHostAddress &addr,const QHostAddress &if_addr,
-  		 QString *err_msg);
+  		 QString *err_msg) const;
   unsigned ReadIntegerArg(const QString &arg,bool *ok) const;
-  QHostAddress c_mcast_address;
+  bool ReadNetworkArg(const QString &arg,uint32_t *addr,
+		      unsigned *prefix_len) const;
+  FilterExpr *CompileExprs(const QStringList &exprs,const QString &conj,
+			   const QString &sw) const;
+  QList<Group> c_groups;
   QHostAddress c_iface_address;
+  QString c_read_filename;
+  CaptureReader *c_reader;
+  bool c_read_paced;
+  bool c_read_pending;
+  PacketView c_read_next;
+  uint64_t c_read_started;
+  uint64_t c_read_elapsed;
+  uint64_t c_read_first_timestamp;
   uint16_t c_port;
+  int c_epoll_fd;
+  QSocketNotifier *c_epoll_notifier;
+  unsigned c_total_slots;
+  struct mmsghdr *c_msgs;
+  struct iovec *c_iovs;
+  struct sockaddr_in *c_names;
+  PacketView *c_pkts;
+  unsigned *c_order;
+  int c_signal_fd;
+  QSocketNotifier *c_signal_notifier;
+  QTimer *c_read_timer;
+  QTimer *c_duration_timer;
+  QTimer *c_stats_timer;
+  QTimer *c_report_timer;
+  QTimer *c_dup_report_timer;
+  QTimer *c_flush_timer;
+  unsigned c_duration;
+  unsigned c_report_interval;
+  uint64_t c_report_received;
+  uint64_t c_report_output;
+  bool c_finished;
+  Mode c_mode;
+  Format c_format;
+  QString c_output_filename;
+  int c_output_fd;
+  PcapngWriter *c_pcapng;
+  SourceStats *c_source_stats;
+  SourceStats *c_timing_stats;
+  RtpStats *c_rtp_stats;
+  DupFilter *c_dup_filter;
+  unsigned c_dup_window;
+  RateLimiter *c_rate_limiter;
+  unsigned c_sample_interval;
+  unsigned c_max_rate;
+  bool c_show_timing;
+  AdvDecoder *c_adv_decoder;
+  GpioDecoder *c_gpio_decoder;
+  bool c_transitions_only;
+  uint64_t c_source_stats_rendered;
+  uint64_t c_source_stats_last;
   bool c_show_ruler;
   int c_first_offset;
   int c_last_offset;
-  QList<QHostAddress> c_filter_source_addresses;
+  AddressSet c_filter_sources;
+  AddressSet c_exclude_sources;
   QMap<unsigned,char> c_filter_bytes;
-  QMap<unsigned,QString> c_filter_strings;
+  QMap<unsigned,QByteArray> c_filter_strings;
+  QStringList c_filter_exprs;
+  FilterExpr *c_filter_expr;
+  FlightRecorder *c_recorder;
+  unsigned c_ring_packets;
+  unsigned c_ring_seconds;
+  QStringList c_trigger_exprs;
+  FilterExpr *c_trigger_expr;
+  unsigned c_post_trigger;
+  unsigned c_post_trigger_remaining;
+  uint64_t c_recorder_dumps;
   unsigned c_packet_limit;
+  unsigned c_batch_size;
+  bool c_show_batch_stats;
+  uint64_t c_batch_calls;
+  uint64_t c_batch_packets;
+  uint64_t c_batch_full;
+  bool c_kernel_filter;
+  bool c_kernel_filter_active;
+  bool c_kernel_filter_sources;
+  bool c_kernel_filter_excludes;
+  uint64_t c_kernel_filter_mismatches;
+  OutputBuffer *c_output;
+  HexDump *c_hexdump;
+  DeltaDump *c_delta_dump;
+  PacketFormatter *c_packet_formatter;
+  PacketFormatter::Encoding c_payload_encoding;
+  FormatPool *c_format_pool;
+  unsigned c_workers;
 };
 
 
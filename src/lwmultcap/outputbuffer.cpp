@@ -0,0 +1,126 @@
+// outputbuffer.cpp
+//
+// Reusable output buffer, flushed with a single write(2)
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "outputbuffer.h"
+
+OutputBuffer::OutputBuffer(unsigned size)
+{
+  buf_capacity=size;
+  buf_used=0;
+  buf_data=(char *)malloc(buf_capacity);
+}
+
+
+OutputBuffer::~OutputBuffer()
+{
+  free(buf_data);
+}
+
+
+void OutputBuffer::appendf(const char *fmt,...)
+{
+  va_list args;
+  int n;
+  unsigned avail=buf_capacity-buf_used;
+
+  va_start(args,fmt);
+  n=vsnprintf(buf_data+buf_used,avail,fmt,args);
+  va_end(args);
+  if(n<0) {
+    return;
+  }
+  if((unsigned)n>=avail) {
+    reserve(n+1);
+    va_start(args,fmt);
+    vsnprintf(buf_data+buf_used,n+1,fmt,args);
+    va_end(args);
+  }
+  buf_used+=n;
+}
+
+
+void OutputBuffer::appendJsonString(const char *str,unsigned len)
+{
+  static const char hex[]="0123456789abcdef";
+  char *p=reserve(2+6*len);  // Worst case, every byte escaped
+  char *start=p;
+
+  *p++='"';
+  for(unsigned i=0;i<len;i++) {
+    uint8_t c=str[i];
+    if((c=='"')||(c=='\\')) {
+      *p++='\\';
+      *p++=c;
+    }
+    else if((c<0x20)||(c>=0x80)) {  // Anything above ASCII taken as Latin-1
+      *p++='\\';
+      *p++='u';
+      *p++='0';
+      *p++='0';
+      *p++=hex[c>>4];
+      *p++=hex[c&0x0F];
+    }
+    else {
+      *p++=c;
+    }
+  }
+  *p++='"';
+  commit(p-start);
+}
+
+
+bool OutputBuffer::flush(int fd)
+{
+  unsigned written=0;
+  ssize_t n;
+
+  while(written<buf_used) {
+    if((n=write(fd,buf_data+written,buf_used-written))<0) {
+      if(errno==EINTR) {
+	continue;
+      }
+      buf_used=0;
+      return false;
+    }
+    written+=n;
+  }
+  buf_used=0;
+
+  return true;
+}
+
+
+void OutputBuffer::Grow(unsigned len)
+{
+  while(buf_capacity<len) {
+    buf_capacity*=2;
+  }
+  if((buf_data=(char *)realloc(buf_data,buf_capacity))==NULL) {
+    fprintf(stderr,"lwmultcap: out of memory\n");
+    exit(1);
+  }
+}
@@ -0,0 +1,76 @@
+// outputbuffer.h
+//
+// Reusable output buffer, flushed with a single write(2)
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef OUTPUTBUFFER_H
+#define OUTPUTBUFFER_H
+
+#include <string.h>
+
+#define OUTPUTBUFFER_DEFAULT_SIZE 262144
+
+class OutputBuffer
+{
+ public:
+  OutputBuffer(unsigned size=OUTPUTBUFFER_DEFAULT_SIZE);
+  ~OutputBuffer();
+  const char *data() const { return buf_data; }
+  unsigned size() const { return buf_used; }
+  unsigned capacity() const { return buf_capacity; }
+  bool isEmpty() const { return buf_used==0; }
+  void clear() { buf_used=0; }
+
+  //
+  // Return a pointer to at least 'len' bytes of free space; follow with
+  // commit() to say how many were actually used
+  //
+  char *reserve(unsigned len)
+  {
+    if((buf_used+len)>buf_capacity) {
+      Grow(buf_used+len);
+    }
+    return buf_data+buf_used;
+  }
+  void commit(unsigned len) { buf_used+=len; }
+
+  void append(const char *str,unsigned len)
+  {
+    memcpy(reserve(len),str,len);
+    buf_used+=len;
+  }
+  void append(const char *str) { append(str,strlen(str)); }
+  void append(char c)
+  {
+    *reserve(1)=c;
+    buf_used++;
+  }
+  void appendf(const char *fmt,...)
+    __attribute__((format(printf,2,3)));
+  void appendJsonString(const char *str,unsigned len);
+  bool flush(int fd);
+
+ private:
+  void Grow(unsigned len);
+  char *buf_data;
+  unsigned buf_used;
+  unsigned buf_capacity;
+};
+
+
+#endif  // OUTPUTBUFFER_H
@@ -0,0 +1,211 @@
+// packetformatter.cpp
+//
+// Render packets as JSON Lines or CSV records for lwmultcap(1)
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <string.h>
+
+#include "packetformatter.h"
+
+static const char packetformatter_hex[]="0123456789abcdef";
+static const char packetformatter_base64[]=
+  "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+PacketFormatter::PacketFormatter()
+{
+  fmt_encoding=PacketFormatter::EncodingHex;
+  for(unsigned i=0;i<256;i++) {
+    fmt_hex[i][0]=packetformatter_hex[i>>4];
+    fmt_hex[i][1]=packetformatter_hex[i&0x0F];
+  }
+}
+
+
+void PacketFormatter::setEncoding(Encoding enc)
+{
+  fmt_encoding=enc;
+}
+
+
+void PacketFormatter::formatJson(OutputBuffer *out,
+				 const PacketView &pkt) const
+{
+  char *start=
+    out->reserve(PACKETFORMATTER_MAX_OVERHEAD+PayloadSize(pkt.size()));
+  char *p=start;
+
+  p=PutString(p,"{\"time\":");
+  p=PutTime(p,pkt.timestamp());
+  p=PutString(p,",\"source\":\"");
+  p=PutAddress(p,pkt.srcAddress(),pkt.srcPort());
+  p=PutString(p,"\",\"destination\":\"");
+  p=PutAddress(p,pkt.dstAddress(),pkt.dstPort());
+  p=PutString(p,"\",\"size\":");
+  p=PutDecimal(p,pkt.size());
+  if(fmt_encoding==PacketFormatter::EncodingBase64) {
+    p=PutString(p,",\"base64\":\"");
+  }
+  else {
+    p=PutString(p,",\"hex\":\"");
+  }
+  p=PutPayload(p,(const uint8_t *)pkt.data(),pkt.size());
+  p=PutString(p,"\"}\n");
+  out->commit(p-start);
+}
+
+
+void PacketFormatter::formatCsvHeader(OutputBuffer *out) const
+{
+  if(fmt_encoding==PacketFormatter::EncodingBase64) {
+    out->append("time,source,destination,size,base64\n");
+  }
+  else {
+    out->append("time,source,destination,size,hex\n");
+  }
+}
+
+
+void PacketFormatter::formatCsv(OutputBuffer *out,const PacketView &pkt) const
+{
+  char *start=
+    out->reserve(PACKETFORMATTER_MAX_OVERHEAD+PayloadSize(pkt.size()));
+  char *p=start;
+
+  //
+  // No field can contain a comma or a quote, so none need quoting
+  //
+  p=PutTime(p,pkt.timestamp());
+  *p++=',';
+  p=PutAddress(p,pkt.srcAddress(),pkt.srcPort());
+  *p++=',';
+  p=PutAddress(p,pkt.dstAddress(),pkt.dstPort());
+  *p++=',';
+  p=PutDecimal(p,pkt.size());
+  *p++=',';
+  p=PutPayload(p,(const uint8_t *)pkt.data(),pkt.size());
+  *p++='\n';
+  out->commit(p-start);
+}
+
+
+char *PacketFormatter::PutString(char *p,const char *str) const
+{
+  unsigned len=strlen(str);  // Constant-folded for literals
+
+  memcpy(p,str,len);
+  return p+len;
+}
+
+
+char *PacketFormatter::PutDecimal(char *p,uint64_t val) const
+{
+  char digits[20];
+  int n=0;
+
+  do {
+    digits[n++]='0'+(val%10);
+    val/=10;
+  } while(val>0);
+  while(n>0) {
+    *p++=digits[--n];
+  }
+  return p;
+}
+
+
+//
+// Seconds since the epoch, with nine decimal places
+//
+char *PacketFormatter::PutTime(char *p,uint64_t timestamp) const
+{
+  uint32_t frac=timestamp%1000000000;
+
+  p=PutDecimal(p,timestamp/1000000000);
+  *p++='.';
+  for(int i=8;i>=0;i--) {
+    p[i]='0'+(frac%10);
+    frac/=10;
+  }
+  return p+9;
+}
+
+
+char *PacketFormatter::PutAddress(char *p,uint32_t addr,uint16_t port) const
+{
+  p=PutDecimal(p,0xFF&(addr>>24));
+  *p++='.';
+  p=PutDecimal(p,0xFF&(addr>>16));
+  *p++='.';
+  p=PutDecimal(p,0xFF&(addr>>8));
+  *p++='.';
+  p=PutDecimal(p,0xFF&addr);
+  *p++=':';
+  return PutDecimal(p,port);
+}
+
+
+char *PacketFormatter::PutPayload(char *p,const uint8_t *data,int len) const
+{
+  int i;
+
+  if(fmt_encoding==PacketFormatter::EncodingHex) {
+    for(i=0;i<len;i++) {
+      memcpy(p,fmt_hex[data[i]],2);
+      p+=2;
+    }
+    return p;
+  }
+
+  //
+  // Base64 (RFC 4648), padded
+  //
+  for(i=0;(i+3)<=len;i+=3) {
+    uint32_t w=(data[i]<<16)|(data[i+1]<<8)|data[i+2];
+    p[0]=packetformatter_base64[0x3F&(w>>18)];
+    p[1]=packetformatter_base64[0x3F&(w>>12)];
+    p[2]=packetformatter_base64[0x3F&(w>>6)];
+    p[3]=packetformatter_base64[0x3F&w];
+    p+=4;
+  }
+  if((len-i)==1) {
+    uint32_t w=data[i]<<16;
+    p[0]=packetformatter_base64[0x3F&(w>>18)];
+    p[1]=packetformatter_base64[0x3F&(w>>12)];
+    p[2]='=';
+    p[3]='=';
+    p+=4;
+  }
+  else if((len-i)==2) {
+    uint32_t w=(data[i]<<16)|(data[i+1]<<8);
+    p[0]=packetformatter_base64[0x3F&(w>>18)];
+    p[1]=packetformatter_base64[0x3F&(w>>12)];
+    p[2]=packetformatter_base64[0x3F&(w>>6)];
+    p[3]='=';
+    p+=4;
+  }
+  return p;
+}
+
+
+unsigned PacketFormatter::PayloadSize(int len) const
+{
+  if(fmt_encoding==PacketFormatter::EncodingBase64) {
+    return 4*((len+2)/3);
+  }
+  return 2*len;
+}
@@ -0,0 +1,61 @@
+// packetformatter.h
+//
+// Render packets as JSON Lines or CSV records for lwmultcap(1)
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef PACKETFORMATTER_H
+#define PACKETFORMATTER_H
+
+#include <stdint.h>
+
+#include "outputbuffer.h"
+#include "packetview.h"
+
+//
+// Longest possible record, less the payload
+//
+#define PACKETFORMATTER_MAX_OVERHEAD 160
+
+//
+// Each record is rendered straight into the output buffer with
+// table-driven conversions, rather than through printf(), so that a
+// record costs little more than encoding its payload.
+//
+class PacketFormatter
+{
+ public:
+  enum Encoding {EncodingHex=0,EncodingBase64=1};
+  PacketFormatter();
+  void setEncoding(Encoding enc);
+  void formatJson(OutputBuffer *out,const PacketView &pkt) const;
+  void formatCsvHeader(OutputBuffer *out) const;
+  void formatCsv(OutputBuffer *out,const PacketView &pkt) const;
+
+ private:
+  char *PutString(char *p,const char *str) const;
+  char *PutDecimal(char *p,uint64_t val) const;
+  char *PutTime(char *p,uint64_t timestamp) const;
+  char *PutAddress(char *p,uint32_t addr,uint16_t port) const;
+  char *PutPayload(char *p,const uint8_t *data,int len) const;
+  unsigned PayloadSize(int len) const;
+  Encoding fmt_encoding;
+  char fmt_hex[256][2];
+};
+
+
+#endif  // PACKETFORMATTER_H
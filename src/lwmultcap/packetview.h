@@ -0,0 +1,108 @@
+// packetview.h
+//
+// Non-owning view of a received packet payload and its delivery details
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef PACKETVIEW_H
+#define PACKETVIEW_H
+
+#include <stdint.h>
+#include <string.h>
+
+//
+// Points into the receive buffer; the caller must keep that buffer
+// alive and unmodified for as long as the view is in use. Addresses
+// and ports are in host byte order; the timestamp is the kernel receive
+// time in nanoseconds since the epoch, or zero if none was delivered.
+//
+class PacketView
+{
+ public:
+  PacketView()
+    : view_data(NULL),view_size(0),view_dst_addr(0),view_dst_port(0),
+    view_src_addr(0),view_src_port(0),view_timestamp(0),view_group(0) {}
+  PacketView(const char *data,int size)
+    : view_data(data),view_size(size),view_dst_addr(0),view_dst_port(0),
+    view_src_addr(0),view_src_port(0),view_timestamp(0),view_group(0) {}
+  const char *data() const { return view_data; }
+  int size() const { return view_size; }
+  char at(int n) const { return view_data[n]; }
+  uint32_t dstAddress() const { return view_dst_addr; }
+  uint16_t dstPort() const { return view_dst_port; }
+  void setDestination(uint32_t addr,uint16_t port)
+  {
+    view_dst_addr=addr;
+    view_dst_port=port;
+  }
+  uint32_t srcAddress() const { return view_src_addr; }
+  uint16_t srcPort() const { return view_src_port; }
+  void setSource(uint32_t addr,uint16_t port)
+  {
+    view_src_addr=addr;
+    view_src_port=port;
+  }
+  uint64_t timestamp() const { return view_timestamp; }
+  void setTimestamp(uint64_t nsecs) { view_timestamp=nsecs; }
+  unsigned group() const { return view_group; }
+  void setGroup(unsigned group) { view_group=group; }
+
+  //
+  // Drop the first 'n' bytes
+  //
+  void chopFront(int n)
+  {
+    if(n>view_size) {
+      n=view_size;
+    }
+    view_data+=n;
+    view_size-=n;
+  }
+
+  //
+  // Keep at most the first 'n' bytes
+  //
+  void truncate(int n)
+  {
+    if(n<view_size) {
+      view_size=n;
+    }
+  }
+
+  //
+  // True if 'len' bytes of 'str' appear in full at 'offset'
+  //
+  bool matches(unsigned offset,const char *str,int len) const
+  {
+    return (offset<(unsigned)view_size)&&
+      ((offset+len)<=(unsigned)view_size)&&
+      (memcmp(view_data+offset,str,len)==0);
+  }
+
+ private:
+  const char *view_data;
+  int view_size;
+  uint32_t view_dst_addr;
+  uint16_t view_dst_port;
+  uint32_t view_src_addr;
+  uint16_t view_src_port;
+  uint64_t view_timestamp;
+  unsigned view_group;
+};
+
+
+#endif  // PACKETVIEW_H
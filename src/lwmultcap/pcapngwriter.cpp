@@ -0,0 +1,376 @@
+// pcapngwriter.cpp
+//
+// Write captured packets to a pcapng file from a background thread
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+
+#include <QMutexLocker>
+
+#include "pcapngwriter.h"
+
+//
+// pcapng block types and fields
+//
+#define PCAPNG_SHB_TYPE 0x0A0D0D0A
+#define PCAPNG_IDB_TYPE 0x00000001
+#define PCAPNG_EPB_TYPE 0x00000006
+#define PCAPNG_BYTE_ORDER_MAGIC 0x1A2B3C4D
+#define PCAPNG_LINKTYPE_ETHERNET 1
+#define PCAPNG_SNAPLEN 65535
+#define PCAPNG_OPT_ENDOFOPT 0
+#define PCAPNG_OPT_IF_TSRESOL 9
+
+//
+// Size of the synthesized Ethernet, IPv4 and UDP headers
+//
+#define PCAPNG_FRAME_HEADER_SIZE (14+20+8)
+
+static char *Put16(char *p,uint16_t val)
+{
+  memcpy(p,&val,2);
+  return p+2;
+}
+
+
+static char *Put32(char *p,uint32_t val)
+{
+  memcpy(p,&val,4);
+  return p+4;
+}
+
+
+static char *PutNet16(char *p,uint16_t val)
+{
+  p[0]=0xFF&(val>>8);
+  p[1]=0xFF&val;
+  return p+2;
+}
+
+
+static char *PutNet32(char *p,uint32_t val)
+{
+  p[0]=0xFF&(val>>24);
+  p[1]=0xFF&(val>>16);
+  p[2]=0xFF&(val>>8);
+  p[3]=0xFF&val;
+  return p+4;
+}
+
+
+PcapngWriter::PcapngWriter(QObject *parent)
+  : QThread(parent)
+{
+  pcap_fd=-1;
+  pcap_block=NULL;
+  pcap_block_started=0;
+  pcap_exiting=false;
+  pcap_write_error=false;
+  pcap_written=0;
+  pcap_dropped=0;
+  pcap_blocking=false;
+}
+
+
+PcapngWriter::~PcapngWriter()
+{
+  close();
+  if(pcap_block!=NULL) {
+    delete pcap_block;
+  }
+  for(int i=0;i<pcap_free_blocks.size();i++) {
+    delete pcap_free_blocks.at(i);
+  }
+}
+
+
+bool PcapngWriter::open(const QString &filename,QString *err_msg)
+{
+  if(filename.isEmpty()||(filename=="-")) {
+    pcap_fd=1;
+  }
+  else {
+    if((pcap_fd=::open(filename.toUtf8().constData(),
+		       O_WRONLY|O_CREAT|O_TRUNC,0644))<0) {
+      *err_msg=strerror(errno);
+      return false;
+    }
+  }
+  for(int i=0;i<PCAPNGWRITER_BLOCK_COUNT;i++) {
+    pcap_free_blocks.push_back(new OutputBuffer(PCAPNGWRITER_BLOCK_SIZE));
+  }
+  pcap_block=pcap_free_blocks.takeFirst();
+  pcap_exiting=false;
+  WriteHeader();
+  start();
+
+  return true;
+}
+
+
+void PcapngWriter::setBlocking(bool state)
+{
+  QMutexLocker locker(&pcap_mutex);
+
+  pcap_blocking=state;
+}
+
+
+void PcapngWriter::close()
+{
+  if(pcap_fd<0) {
+    return;
+  }
+  if((pcap_block!=NULL)&&(!pcap_block->isEmpty())) {
+    HandOff();
+  }
+  pcap_mutex.lock();
+  pcap_exiting=true;
+  pcap_wait.wakeAll();
+  pcap_mutex.unlock();
+  wait();
+  if(pcap_fd!=1) {
+    ::close(pcap_fd);
+  }
+  pcap_fd=-1;
+}
+
+
+void PcapngWriter::writePacket(const PacketView &pkt)
+{
+  unsigned frame_len=PCAPNG_FRAME_HEADER_SIZE+pkt.size();
+  unsigned block_len=28+((frame_len+3)&~3u)+4;
+  uint64_t ts=pkt.timestamp();
+  uint32_t sum=0;
+  char *start;
+  char *p;
+  char *ip;
+
+  if((pcap_block==NULL)||
+     ((pcap_block->size()+block_len)>pcap_block->capacity())) {
+    HandOff();
+  }
+  if(pcap_block==NULL) {
+    pcap_dropped++;
+    return;
+  }
+  if(pcap_block->isEmpty()) {
+    pcap_block_started=Now(CLOCK_MONOTONIC);
+  }
+  if(ts==0) {
+    ts=Now(CLOCK_REALTIME);
+  }
+
+  //
+  // Enhanced Packet Block
+  //
+  start=p=pcap_block->reserve(block_len);
+  p=Put32(p,PCAPNG_EPB_TYPE);
+  p=Put32(p,block_len);
+  p=Put32(p,0);  // Interface ID
+  p=Put32(p,ts>>32);
+  p=Put32(p,0xFFFFFFFF&ts);
+  p=Put32(p,frame_len);
+  p=Put32(p,frame_len);
+
+  //
+  // Ethernet, with the multicast MAC for the group and a locally
+  // administered one made up from the source address
+  //
+  if((pkt.dstAddress()>>28)==0xE) {
+    p=PutNet16(p,0x0100);
+    p=PutNet32(p,0x5E000000|(0x7FFFFF&pkt.dstAddress()));
+  }
+  else {
+    p=PutNet16(p,0x0200);
+    p=PutNet32(p,pkt.dstAddress());
+  }
+  p=PutNet16(p,0x0200);
+  p=PutNet32(p,pkt.srcAddress());
+  p=PutNet16(p,0x0800);  // IPv4
+
+  //
+  // IPv4
+  //
+  ip=p;
+  p=PutNet16(p,0x4500);
+  p=PutNet16(p,20+8+pkt.size());
+  p=PutNet32(p,0);       // ID, flags, fragment offset
+  p=PutNet16(p,0x0111);  // TTL 1, UDP
+  p=PutNet16(p,0);       // Checksum, filled in below
+  p=PutNet32(p,pkt.srcAddress());
+  p=PutNet32(p,pkt.dstAddress());
+  for(int i=0;i<20;i+=2) {
+    sum+=((0xFF&ip[i])<<8)|(0xFF&ip[i+1]);
+  }
+  while((sum>>16)!=0) {
+    sum=(sum&0xFFFF)+(sum>>16);
+  }
+  PutNet16(ip+10,0xFFFF&~sum);
+
+  //
+  // UDP, without a checksum
+  //
+  p=PutNet16(p,pkt.srcPort());
+  p=PutNet16(p,pkt.dstPort());
+  p=PutNet16(p,8+pkt.size());
+  p=PutNet16(p,0);
+
+  memcpy(p,pkt.data(),pkt.size());
+  p+=pkt.size();
+  while(((p-start)&3)!=0) {
+    *p++=0;
+  }
+  Put32(p,block_len);
+  pcap_block->commit(block_len);
+  pcap_written++;
+}
+
+
+void PcapngWriter::poll()
+{
+  //
+  // Don't let a trickle of packets sit in a part-filled block for
+  // long, in case someone is watching the output live
+  //
+  if((pcap_block==NULL)||
+     ((!pcap_block->isEmpty())&&
+      ((Now(CLOCK_MONOTONIC)-pcap_block_started)>=
+       (uint64_t)PCAPNGWRITER_FLUSH_INTERVAL*1000000))) {
+    HandOff();
+  }
+}
+
+
+uint64_t PcapngWriter::packetsWritten() const
+{
+  return pcap_written;
+}
+
+
+uint64_t PcapngWriter::packetsDropped() const
+{
+  return pcap_dropped;
+}
+
+
+bool PcapngWriter::writeError() const
+{
+  return pcap_write_error;
+}
+
+
+void PcapngWriter::run()
+{
+  OutputBuffer *block;
+
+  pcap_mutex.lock();
+  while(true) {
+    while(pcap_full_blocks.isEmpty()&&(!pcap_exiting)) {
+      pcap_wait.wait(&pcap_mutex);
+    }
+    if(pcap_full_blocks.isEmpty()) {
+      break;
+    }
+    block=pcap_full_blocks.takeFirst();
+    pcap_mutex.unlock();
+    if((!pcap_write_error)&&(!block->flush(pcap_fd))) {
+      pcap_write_error=true;
+    }
+    block->clear();
+    pcap_mutex.lock();
+    pcap_free_blocks.push_back(block);
+    pcap_free_wait.wakeOne();
+  }
+  pcap_mutex.unlock();
+}
+
+
+void PcapngWriter::HandOff()
+{
+  //
+  // Queue the current block, if any, and take a free one, if any
+  //
+  QMutexLocker locker(&pcap_mutex);
+
+  if(pcap_block!=NULL) {
+    pcap_full_blocks.push_back(pcap_block);
+    pcap_wait.wakeOne();
+  }
+  pcap_block=NULL;
+  if(pcap_blocking) {
+    while(pcap_free_blocks.isEmpty()) {
+      pcap_free_wait.wait(&pcap_mutex);
+    }
+  }
+  if(!pcap_free_blocks.isEmpty()) {
+    pcap_block=pcap_free_blocks.takeFirst();
+  }
+}
+
+
+void PcapngWriter::WriteHeader()
+{
+  char *p;
+
+  //
+  // Section Header Block
+  //
+  p=pcap_block->reserve(28);
+  p=Put32(p,PCAPNG_SHB_TYPE);
+  p=Put32(p,28);
+  p=Put32(p,PCAPNG_BYTE_ORDER_MAGIC);
+  p=Put16(p,1);  // Major version
+  p=Put16(p,0);  // Minor version
+  p=Put32(p,0xFFFFFFFF);  // Section length unknown
+  p=Put32(p,0xFFFFFFFF);
+  Put32(p,28);
+  pcap_block->commit(28);
+
+  //
+  // Interface Description Block, with nanosecond timestamps
+  //
+  p=pcap_block->reserve(32);
+  p=Put32(p,PCAPNG_IDB_TYPE);
+  p=Put32(p,32);
+  p=Put16(p,PCAPNG_LINKTYPE_ETHERNET);
+  p=Put16(p,0);
+  p=Put32(p,PCAPNG_SNAPLEN);
+  p=Put16(p,PCAPNG_OPT_IF_TSRESOL);
+  p=Put16(p,1);
+  *p++=9;  // 10^-9
+  *p++=0;  // Padding
+  p=Put16(p,0);
+  p=Put16(p,PCAPNG_OPT_ENDOFOPT);
+  p=Put16(p,0);
+  Put32(p,32);
+  pcap_block->commit(32);
+}
+
+
+uint64_t PcapngWriter::Now(clockid_t clock)
+{
+  struct timespec ts;
+
+  clock_gettime(clock,&ts);
+  return (uint64_t)ts.tv_sec*1000000000+ts.tv_nsec;
+}
@@ -0,0 +1,84 @@
+// pcapngwriter.h
+//
+// Write captured packets to a pcapng file from a background thread
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef PCAPNGWRITER_H
+#define PCAPNGWRITER_H
+
+#include <stdint.h>
+#include <time.h>
+
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+
+#include "outputbuffer.h"
+#include "packetview.h"
+
+#define PCAPNGWRITER_BLOCK_SIZE 1048576
+#define PCAPNGWRITER_BLOCK_COUNT 16
+#define PCAPNGWRITER_FLUSH_INTERVAL 500  // mS
+
+//
+// Packets are encoded into a block on the receive thread; full blocks
+// are handed to run() to be written out. Blocks are recycled, and if the
+// writer falls so far behind that none are free then packets are
+// dropped and counted rather than making the receive thread wait ---
+// unless setBlocking() is in effect, as when reading from a file.
+//
+class PcapngWriter : public QThread
+{
+ public:
+  PcapngWriter(QObject *parent=0);
+  ~PcapngWriter();
+  bool open(const QString &filename,QString *err_msg);
+  void setBlocking(bool state);
+  void close();
+  void writePacket(const PacketView &pkt);
+  void poll();
+  uint64_t packetsWritten() const;
+  uint64_t packetsDropped() const;
+  bool writeError() const;
+
+ protected:
+  void run();
+
+ private:
+  void HandOff();
+  void WriteHeader();
+  static uint64_t Now(clockid_t clock);
+  int pcap_fd;
+  OutputBuffer *pcap_block;
+  uint64_t pcap_block_started;
+  QList<OutputBuffer *> pcap_free_blocks;
+  QList<OutputBuffer *> pcap_full_blocks;
+  QMutex pcap_mutex;
+  QWaitCondition pcap_wait;
+  QWaitCondition pcap_free_wait;
+  bool pcap_blocking;
+  bool pcap_exiting;
+  bool pcap_write_error;
+  uint64_t pcap_written;
+  uint64_t pcap_dropped;
+};
+
+
+#endif  // PCAPNGWRITER_H
@@ -0,0 +1,62 @@
+// ratelimiter.cpp
+//
+// Output sampling and rate limiting for lwmultcap(1)
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include "ratelimiter.h"
+
+RateLimiter::RateLimiter()
+{
+  rate_sample_interval=1;
+  rate_sample_count=0;
+  rate_cost=0;
+  rate_credit=0;
+  rate_last=0;
+  rate_seen=0;
+  rate_admitted=0;
+}
+
+
+void RateLimiter::setSampleInterval(unsigned n)
+{
+  rate_sample_interval=n;
+  rate_sample_count=n-1;  // So that the first one gets through
+}
+
+
+void RateLimiter::setMaxRate(unsigned pps)
+{
+  if(pps==0) {
+    rate_cost=0;
+  }
+  else {
+    rate_cost=1000000000ull/pps;
+  }
+}
+
+
+uint64_t RateLimiter::packetsSeen() const
+{
+  return rate_seen;
+}
+
+
+uint64_t RateLimiter::packetsAdmitted() const
+{
+  return rate_admitted;
+}
@@ -0,0 +1,84 @@
+// ratelimiter.h
+//
+// Output sampling and rate limiting for lwmultcap(1)
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef RATELIMITER_H
+#define RATELIMITER_H
+
+#include <stdint.h>
+
+//
+// The token bucket is kept in nanoseconds of credit rather than in
+// packets, so that refilling it from the packet timestamps needs no
+// division. It holds at most one second's worth, which is also the
+// largest burst let through after a quiet spell.
+//
+#define RATELIMITER_BURST 1000000000ull  // nS
+
+class RateLimiter
+{
+ public:
+  RateLimiter();
+  void setSampleInterval(unsigned n);
+  void setMaxRate(unsigned pps);
+  uint64_t packetsSeen() const;
+  uint64_t packetsAdmitted() const;
+
+  //
+  // True if the packet with kernel timestamp 'timestamp' should be
+  // output
+  //
+  bool admit(uint64_t timestamp)
+  {
+    rate_seen++;
+    if(rate_sample_interval>1) {
+      if(++rate_sample_count<rate_sample_interval) {
+	return false;
+      }
+      rate_sample_count=0;
+    }
+    if(rate_cost>0) {
+      if(timestamp>rate_last) {
+	rate_credit+=timestamp-rate_last;
+	if(rate_credit>RATELIMITER_BURST) {
+	  rate_credit=RATELIMITER_BURST;
+	}
+	rate_last=timestamp;
+      }
+      if(rate_credit<rate_cost) {
+	return false;
+      }
+      rate_credit-=rate_cost;
+    }
+    rate_admitted++;
+    return true;
+  }
+
+ private:
+  unsigned rate_sample_interval;
+  unsigned rate_sample_count;
+  uint64_t rate_cost;
+  uint64_t rate_credit;
+  uint64_t rate_last;
+  uint64_t rate_seen;
+  uint64_t rate_admitted;
+};
+
+
+#endif  // RATELIMITER_H
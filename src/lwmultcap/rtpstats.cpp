@@ -0,0 +1,338 @@
+// rtpstats.cpp
+//
+// Per-stream RTP sequence and timestamp analysis for lwmultcap(1)
+//
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+
+#include "hexdump.h"
+#include "rtpstats.h"
+
+RtpStats::RtpStats()
+{
+  rtp_streams=new Stream[RTPSTATS_TABLE_SIZE];
+  memset(rtp_streams,0,RTPSTATS_TABLE_SIZE*sizeof(Stream));
+  rtp_order.reserve(RTPSTATS_MAX_STREAMS);
+  rtp_used=0;
+  rtp_interval_start=0;
+  rtp_skipped=0;
+  rtp_untracked=0;
+}
+
+
+RtpStats::~RtpStats()
+{
+  delete[] rtp_streams;
+}
+
+
+void RtpStats::update(OutputBuffer *out,const PacketView &pkt)
+{
+  const uint8_t *data=(const uint8_t *)pkt.data();
+  uint16_t seq;
+  uint16_t udelta;
+  uint32_t timestamp;
+  uint32_t ssrc;
+  Stream *s;
+
+  advance(out,pkt.timestamp());
+
+  //
+  // Fixed header, plus any CSRCs
+  //
+  if((pkt.size()<12)||((data[0]>>6)!=2)||
+     (pkt.size()<(12+4*(data[0]&0x0F)))) {
+    rtp_skipped++;
+    return;
+  }
+  seq=(data[2]<<8)|data[3];
+  timestamp=((uint32_t)data[4]<<24)|(data[5]<<16)|(data[6]<<8)|data[7];
+  ssrc=((uint32_t)data[8]<<24)|(data[9]<<16)|(data[10]<<8)|data[11];
+  if((s=Find(ssrc,pkt.dstAddress(),pkt.dstPort()))==NULL) {
+    rtp_untracked++;
+    return;
+  }
+  s->payload_type=data[1]&0x7F;
+  s->total.packets++;
+  s->interval.packets++;
+
+  if(!s->used) {
+    s->used=true;
+    s->ssrc=ssrc;
+    s->dst_addr=pkt.dstAddress();
+    s->dst_port=pkt.dstPort();
+    s->src_addr=pkt.srcAddress();
+    s->src_port=pkt.srcPort();
+    s->max_seq=seq;
+    s->last_timestamp=timestamp;
+    s->total.received++;
+    s->total.expected++;
+    s->interval.received++;
+    s->interval.expected++;
+    rtp_order.push_back(s-rtp_streams);
+    rtp_used++;
+    return;
+  }
+
+  udelta=seq-s->max_seq;
+  if(udelta==0) {
+    s->total.duplicates++;
+    s->interval.duplicates++;
+    return;
+  }
+  s->total.received++;
+  s->interval.received++;
+  if(udelta<RTPSTATS_MAX_DROPOUT) {
+    if(s->step_known) {
+      if((timestamp-s->last_timestamp)!=(uint32_t)(s->timestamp_step*udelta)) {
+	s->total.discontinuities++;
+	s->interval.discontinuities++;
+	s->step_known=false;  // Learn it again
+      }
+    }
+    else {
+      if(udelta==1) {
+	s->timestamp_step=timestamp-s->last_timestamp;
+	s->step_known=true;
+      }
+    }
+    s->total.expected+=udelta;
+    s->interval.expected+=udelta;
+    s->max_seq=seq;
+    s->last_timestamp=timestamp;
+    return;
+  }
+  if(udelta>=(0x10000-RTPSTATS_MAX_MISORDER)) {
+    s->total.reordered++;
+    s->interval.reordered++;
+    return;
+  }
+
+  //
+  // Restarted
+  //
+  s->total.discontinuities++;
+  s->interval.discontinuities++;
+  s->total.expected++;
+  s->interval.expected++;
+  s->max_seq=seq;
+  s->last_timestamp=timestamp;
+  s->step_known=false;
+}
+
+
+//
+// Emit the summary for the current second if 'now' is past it
+//
+void RtpStats::advance(OutputBuffer *out,uint64_t now)
+{
+  uint64_t next;
+  char time_str[16];
+  struct tm tm;
+  time_t secs;
+
+  if(now==0) {
+    return;
+  }
+  if(rtp_interval_start==0) {
+    rtp_interval_start=now-now%RTPSTATS_INTERVAL;
+    return;
+  }
+  if(now<(rtp_interval_start+RTPSTATS_INTERVAL)) {
+    return;
+  }
+  RenderInterval(out);
+  next=now-now%RTPSTATS_INTERVAL;
+  if(next>(rtp_interval_start+RTPSTATS_INTERVAL)) {
+    secs=(rtp_interval_start+RTPSTATS_INTERVAL)/1000000000;
+    localtime_r(&secs,&tm);
+    strftime(time_str,16,"%H:%M:%S",&tm);
+    out->appendf("%s  no packets for %lu second(s)\n\n",time_str,
+		 (unsigned long)((next-rtp_interval_start)/RTPSTATS_INTERVAL-1));
+    for(unsigned i=0;i<rtp_order.size();i++) {
+      rtp_streams[rtp_order.at(i)].was_active=false;
+    }
+  }
+  rtp_interval_start=next;
+}
+
+
+void RtpStats::renderTotals(OutputBuffer *out)
+{
+  //
+  // Whatever there is of the last second
+  //
+  if(rtp_interval_start!=0) {
+    RenderInterval(out);
+    rtp_interval_start=0;
+  }
+
+  Sort();
+  out->appendf("%-10s  %-21s %-21s %3s %10s %8s %6s %6s %5s %5s\n",
+	       "SSRC","Source","Destination","PT","Packets","Lost","Loss%",
+	       "Reord","Dup","Disc");
+  for(unsigned i=0;i<rtp_order.size();i++) {
+    const Stream *s=rtp_streams+rtp_order.at(i);
+    RenderRow(out,s,s->total,true);
+  }
+  out->appendf("%u stream(s)\n",rtp_used);
+}
+
+
+uint64_t RtpStats::packetsSkipped() const
+{
+  return rtp_skipped;
+}
+
+
+uint64_t RtpStats::packetsUntracked() const
+{
+  return rtp_untracked;
+}
+
+
+RtpStats::Stream *RtpStats::Find(uint32_t ssrc,uint32_t dst_addr,
+				 uint16_t dst_port)
+{
+  uint64_t h=(((uint64_t)ssrc<<32)|dst_addr)*0x9E3779B97F4A7C15ull;
+  unsigned slot=((h>>32)^dst_port)&(RTPSTATS_TABLE_SIZE-1);
+
+  while(rtp_streams[slot].used) {
+    const Stream &s=rtp_streams[slot];
+    if((s.ssrc==ssrc)&&(s.dst_addr==dst_addr)&&(s.dst_port==dst_port)) {
+      return rtp_streams+slot;
+    }
+    slot=(slot+1)&(RTPSTATS_TABLE_SIZE-1);
+  }
+  if(rtp_used==RTPSTATS_MAX_STREAMS) {
+    return NULL;
+  }
+  return rtp_streams+slot;
+}
+
+
+//
+// A heading line with the totals for the second, then a line for each
+// stream heard from in it or in the one before, so that a stream that
+// stops shows up once with no packets
+//
+void RtpStats::RenderInterval(OutputBuffer *out)
+{
+  Counters sum;
+  unsigned active=0;
+  bool header=true;
+  char time_str[16];
+  struct tm tm;
+  time_t secs;
+
+  memset(&sum,0,sizeof(sum));
+  for(unsigned i=0;i<rtp_order.size();i++) {
+    const Counters &c=rtp_streams[rtp_order.at(i)].interval;
+    if(c.packets>0) {
+      active++;
+    }
+    sum.packets+=c.packets;
+    sum.received+=c.received;
+    sum.expected+=c.expected;
+    sum.reordered+=c.reordered;
+    sum.duplicates+=c.duplicates;
+    sum.discontinuities+=c.discontinuities;
+  }
+  secs=rtp_interval_start/1000000000;
+  localtime_r(&secs,&tm);
+  strftime(time_str,16,"%H:%M:%S",&tm);
+  out->appendf("%s  %u stream(s), %lu packets, %lu lost, %lu reordered, %lu duplicates, %lu discontinuities\n",
+	       time_str,active,(unsigned long)sum.packets,
+	       (unsigned long)Lost(sum),(unsigned long)sum.reordered,
+	       (unsigned long)sum.duplicates,
+	       (unsigned long)sum.discontinuities);
+
+  Sort();
+  for(unsigned i=0;i<rtp_order.size();i++) {
+    Stream *s=rtp_streams+rtp_order.at(i);
+    if((s->interval.packets>0)||s->was_active) {
+      if(header) {
+	out->appendf("%-10s  %-21s %-21s %3s %10s %8s %6s %5s %5s\n",
+		     "SSRC","Source","Destination","PT","Packets","Lost",
+		     "Reord","Dup","Disc");
+	header=false;
+      }
+      RenderRow(out,s,s->interval,false);
+    }
+    s->was_active=s->interval.packets>0;
+    memset(&s->interval,0,sizeof(s->interval));
+  }
+  out->append('\n');
+}
+
+
+void RtpStats::RenderRow(OutputBuffer *out,const Stream *s,const Counters &c,
+			 bool percent) const
+{
+  char ssrc_str[12];
+  char src_str[24];
+  char dst_str[24];
+
+  snprintf(ssrc_str,12,"0x%08X",s->ssrc);
+  HexDump::formatAddress(src_str,s->src_addr,s->src_port);
+  HexDump::formatAddress(dst_str,s->dst_addr,s->dst_port);
+  out->appendf("%-10s  %-21s %-21s %3u %10lu %8lu",ssrc_str,src_str,dst_str,
+	       s->payload_type,(unsigned long)c.packets,(unsigned long)Lost(c));
+  if(percent) {
+    out->appendf(" %6.2f",
+		 (c.expected>0)?100.0*(double)Lost(c)/(double)c.expected:0.0);
+  }
+  out->appendf(" %6lu %5lu %5lu\n",(unsigned long)c.reordered,
+	       (unsigned long)c.duplicates,(unsigned long)c.discontinuities);
+}
+
+
+void RtpStats::Sort()
+{
+  const Stream *streams=rtp_streams;
+
+  std::sort(rtp_order.begin(),rtp_order.end(),
+	    [streams](unsigned a,unsigned b) {
+	      const Stream &sa=streams[a];
+	      const Stream &sb=streams[b];
+	      if(sa.dst_addr!=sb.dst_addr) {
+		return sa.dst_addr<sb.dst_addr;
+	      }
+	      if(sa.dst_port!=sb.dst_port) {
+		return sa.dst_port<sb.dst_port;
+	      }
+	      return sa.ssrc<sb.ssrc;
+	    });
+}
+
+
+//
+// Late packets can make up for losses counted in an earlier second,
+// so this may come out negative for a single second; show that as none
+//
+int64_t RtpStats::Lost(const Counters &c)
+{
+  int64_t lost=(int64_t)c.expected-(int64_t)c.received;
+
+  return lost>0?lost:0;
+}
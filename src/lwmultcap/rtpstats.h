@@ -0,0 +1,107 @@
+// rtpstats.h
+//
+// Per-stream RTP sequence and timestamp analysis for lwmultcap(1)
+//
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef RTPSTATS_H
+#define RTPSTATS_H
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "outputbuffer.h"
+#include "packetview.h"
+
+#define RTPSTATS_TABLE_SIZE 4096  // Must be a power of two
+#define RTPSTATS_MAX_STREAMS 2048
+#define RTPSTATS_INTERVAL 1000000000ull  // nS
+#define RTPSTATS_MAX_DROPOUT 3000
+#define RTPSTATS_MAX_MISORDER 100
+
+//
+// Streams are keyed on SSRC and destination, in a fixed-size, linearly
+// probed table that is never more than half full; packets for streams
+// beyond RTPSTATS_MAX_STREAMS are counted but not tracked.
+//
+// Sequence numbers are followed in the manner of RFC 3550 appendix A.1.
+// A packet up to RTPSTATS_MAX_DROPOUT ahead of the highest so far moves
+// it on, with any gap counted as expected but not received; one up to
+// RTPSTATS_MAX_MISORDER behind it is counted as reordered, and makes up
+// for the loss. Anything further away is taken as a restart of the
+// stream. The RTP timestamp is expected to advance by the same amount
+// for each step in sequence number, as it does for audio with a fixed
+// packet duration; when it does not, that is a discontinuity.
+//
+// Summaries cover whole seconds of receive time, and are emitted once
+// a packet (or a call to advance()) shows that the second has ended,
+// so that capture files come out the same as live traffic.
+//
+class RtpStats
+{
+ public:
+  RtpStats();
+  ~RtpStats();
+  void update(OutputBuffer *out,const PacketView &pkt);
+  void advance(OutputBuffer *out,uint64_t now);
+  void renderTotals(OutputBuffer *out);
+  uint64_t packetsSkipped() const;
+  uint64_t packetsUntracked() const;
+
+ private:
+  struct Counters {
+    uint64_t packets;
+    uint64_t received;  // Less duplicates
+    uint64_t expected;
+    uint64_t reordered;
+    uint64_t duplicates;
+    uint64_t discontinuities;
+  };
+  struct Stream {
+    bool used;
+    uint32_t ssrc;
+    uint32_t dst_addr;
+    uint16_t dst_port;
+    uint32_t src_addr;
+    uint16_t src_port;
+    uint8_t payload_type;
+    uint16_t max_seq;
+    uint32_t last_timestamp;
+    uint32_t timestamp_step;
+    bool step_known;
+    bool was_active;
+    Counters total;
+    Counters interval;
+  };
+  Stream *Find(uint32_t ssrc,uint32_t dst_addr,uint16_t dst_port);
+  void RenderInterval(OutputBuffer *out);
+  void RenderRow(OutputBuffer *out,const Stream *s,const Counters &c,
+		 bool percent) const;
+  void Sort();
+  static int64_t Lost(const Counters &c);
+  Stream *rtp_streams;
+  std::vector<unsigned> rtp_order;
+  unsigned rtp_used;
+  uint64_t rtp_interval_start;
+  uint64_t rtp_skipped;
+  uint64_t rtp_untracked;
+};
+
+
+#endif  // RTPSTATS_H
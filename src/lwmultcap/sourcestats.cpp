@@ -0,0 +1,242 @@
+// sourcestats.cpp
+//
+// Per-source traffic statistics for lwmultcap(1)
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+
+#include "hexdump.h"
+#include "sourcestats.h"
+
+SourceStats::SourceStats()
+{
+  Entry empty;
+
+  memset(&empty,0,sizeof(empty));
+  stats_entries.resize(SOURCESTATS_INITIAL_SIZE,empty);
+  stats_order.reserve(SOURCESTATS_INITIAL_SIZE);
+  stats_mask=SOURCESTATS_INITIAL_SIZE-1;
+  stats_used=0;
+}
+
+
+bool SourceStats::update(uint32_t addr,uint16_t port,unsigned len,
+			 uint64_t timestamp,int64_t *delta)
+{
+  uint64_t key=Key(addr,port);
+  Entry *e=Find(key);
+  int64_t gap;
+  bool ret=false;
+
+  if(e->key==0) {
+    if(2*(stats_used+1)>stats_entries.size()) {
+      Grow();
+      e=Find(key);
+    }
+    e->key=key;
+    e->min_size=len;
+    e->max_size=len;
+    stats_used++;
+  }
+  e->packets++;
+  e->bytes+=len;
+  e->interval_packets++;
+  e->interval_bytes+=len;
+  if(len<e->min_size) {
+    e->min_size=len;
+  }
+  if(len>e->max_size) {
+    e->max_size=len;
+  }
+
+  //
+  // Inter-arrival timing
+  //
+  if(e->packets>1) {
+    gap=(int64_t)(timestamp-e->last_seen);
+    if(e->gaps==0) {
+      e->gap_min=gap;
+      e->gap_max=gap;
+    }
+    else {
+      if(gap<e->gap_min) {
+	e->gap_min=gap;
+      }
+      if(gap>e->gap_max) {
+	e->gap_max=gap;
+      }
+      e->jitter+=((double)llabs(gap-e->last_gap)-e->jitter)/16.0;
+    }
+    e->gaps++;
+    e->gap_sum+=gap;
+    e->last_gap=gap;
+    if(delta!=NULL) {
+      *delta=gap;
+    }
+    ret=true;
+  }
+  e->last_seen=timestamp;
+
+  return ret;
+}
+
+
+unsigned SourceStats::sources() const
+{
+  return stats_used;
+}
+
+
+void SourceStats::render(OutputBuffer *out,uint64_t elapsed,bool clear_screen)
+{
+  char src_str[24];
+  char time_str[32];
+  struct tm tm;
+  time_t secs;
+
+  //
+  // Work out the rates for the interval just ended
+  //
+  for(unsigned i=0;i<stats_entries.size();i++) {
+    Entry &e=stats_entries[i];
+    if(e.key!=0) {
+      if(elapsed>0) {
+	e.packet_rate=1e9*(double)e.interval_packets/(double)elapsed;
+	e.byte_rate=1e9*(double)e.interval_bytes/(double)elapsed;
+      }
+      e.interval_packets=0;
+      e.interval_bytes=0;
+    }
+  }
+  Sort();
+
+  if(clear_screen) {
+    out->append("\033[H\033[2J");
+  }
+  out->appendf("%-21s %10s %9s %11s %5s %5s %7s %9s  %-12s\n",
+	       "Source","Packets","Pkts/s","Bytes/s","Min","Max","Avg",
+	       "Jitter/ms","Last Seen");
+  for(unsigned i=0;i<stats_order.size();i++) {
+    const Entry &e=stats_entries[stats_order.at(i)];
+    HexDump::formatAddress(src_str,0xFFFFFFFF&(e.key>>16),0xFFFF&e.key);
+    secs=e.last_seen/1000000000;
+    localtime_r(&secs,&tm);
+    snprintf(time_str,32,"%02d:%02d:%02d.%03u",tm.tm_hour,tm.tm_min,
+	     tm.tm_sec,(unsigned)((e.last_seen/1000000)%1000));
+    out->appendf("%-21s %10lu %9.1f %11.1f %5u %5u %7.1f %9.3f  %-12s\n",
+		 src_str,(unsigned long)e.packets,e.packet_rate,e.byte_rate,
+		 e.min_size,e.max_size,(double)e.bytes/(double)e.packets,
+		 e.jitter/1e6,time_str);
+  }
+  out->appendf("%u source(s)\n",stats_used);
+  if(!clear_screen) {
+    out->append('\n');
+  }
+}
+
+
+void SourceStats::renderTiming(OutputBuffer *out)
+{
+  char src_str[24];
+
+  Sort();
+  out->appendf("%-21s %10s %11s %11s %11s %11s\n",
+	       "Source","Packets","Min Gap/ms","Avg Gap/ms","Max Gap/ms",
+	       "Jitter/ms");
+  for(unsigned i=0;i<stats_order.size();i++) {
+    const Entry &e=stats_entries[stats_order.at(i)];
+    HexDump::formatAddress(src_str,0xFFFFFFFF&(e.key>>16),0xFFFF&e.key);
+    if(e.gaps==0) {
+      out->appendf("%-21s %10lu %11s %11s %11s %11s\n",
+		   src_str,(unsigned long)e.packets,"-","-","-","-");
+    }
+    else {
+      out->appendf("%-21s %10lu %11.3f %11.3f %11.3f %11.3f\n",
+		   src_str,(unsigned long)e.packets,(double)e.gap_min/1e6,
+		   (double)e.gap_sum/(1e6*(double)e.gaps),
+		   (double)e.gap_max/1e6,e.jitter/1e6);
+    }
+  }
+}
+
+
+SourceStats::Entry *SourceStats::Find(uint64_t key)
+{
+  unsigned slot=Hash(key,stats_mask);
+
+  while((stats_entries[slot].key!=0)&&(stats_entries[slot].key!=key)) {
+    slot=(slot+1)&stats_mask;
+  }
+  return &stats_entries[slot];
+}
+
+
+void SourceStats::Grow()
+{
+  std::vector<Entry> old;
+  Entry empty;
+
+  memset(&empty,0,sizeof(empty));
+  old.swap(stats_entries);
+  stats_entries.resize(2*old.size(),empty);
+  stats_order.reserve(stats_entries.size());
+  stats_mask=stats_entries.size()-1;
+  for(unsigned i=0;i<old.size();i++) {
+    if(old.at(i).key!=0) {
+      *Find(old.at(i).key)=old.at(i);
+    }
+  }
+}
+
+
+void SourceStats::Sort()
+{
+  stats_order.clear();
+  for(unsigned i=0;i<stats_entries.size();i++) {
+    if(stats_entries.at(i).key!=0) {
+      stats_order.push_back(i);
+    }
+  }
+  std::sort(stats_order.begin(),stats_order.end(),
+	    [this](unsigned a,unsigned b) {
+	      return stats_entries[a].key<stats_entries[b].key;
+	    });
+}
+
+
+uint64_t SourceStats::Key(uint32_t addr,uint16_t port)
+{
+  //
+  // The high bit keeps 0.0.0.0:0 from looking like an empty slot
+  //
+  return 0x1000000000000ull|((uint64_t)addr<<16)|port;
+}
+
+
+unsigned SourceStats::Hash(uint64_t key,unsigned mask)
+{
+  //
+  // Fibonacci hashing, taking the well-mixed high bits
+  //
+  return (unsigned)((key*0x9E3779B97F4A7C15ull)>>32)&mask;
+}
@@ -0,0 +1,84 @@
+// sourcestats.h
+//
+// Per-source traffic statistics for lwmultcap(1)
+//
+//   (C) Copyright 2026 Fred Gleason <fredg@paravelsystems.com>
+//
+//   This program is free software; you can redistribute it and/or modify
+//   it under the terms of the GNU General Public License version 2 as
+//   published by the Free Software Foundation.
+//
+//   This program is distributed in the hope that it will be useful,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//   GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public
+//   License along with this program; if not, write to the Free Software
+//   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+
+#ifndef SOURCESTATS_H
+#define SOURCESTATS_H
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "outputbuffer.h"
+
+#define SOURCESTATS_INITIAL_SIZE 256
+#define SOURCESTATS_INTERVAL 1000  // mS
+
+//
+// An open-addressed, linearly probed table that doubles whenever it
+// becomes half full, so that after the set of sources settles down
+// update() neither allocates nor probes far.
+//
+// Inter-arrival gaps are measured between kernel receive timestamps of
+// successive packets from the same source. Jitter is smoothed in the
+// manner of RFC 3550 section 6.4.1, taking the change in gap from one
+// packet to the next as the transit difference.
+//
+class SourceStats
+{
+ public:
+  SourceStats();
+  bool update(uint32_t addr,uint16_t port,unsigned len,uint64_t timestamp,
+	      int64_t *delta=NULL);
+  unsigned sources() const;
+  void render(OutputBuffer *out,uint64_t elapsed,bool clear_screen);
+  void renderTiming(OutputBuffer *out);
+
+ private:
+  struct Entry {
+    uint64_t key;  // Zero when the slot is empty
+    uint64_t packets;
+    uint64_t bytes;
+    uint64_t interval_packets;
+    uint64_t interval_bytes;
+    double packet_rate;
+    double byte_rate;
+    unsigned min_size;
+    unsigned max_size;
+    uint64_t last_seen;
+    uint64_t gaps;
+    int64_t gap_sum;
+    int64_t gap_min;
+    int64_t gap_max;
+    int64_t last_gap;
+    double jitter;
+  };
+  Entry *Find(uint64_t key);
+  void Grow();
+  void Sort();
+  static uint64_t Key(uint32_t addr,uint16_t port);
+  static unsigned Hash(uint64_t key,unsigned mask);
+  std::vector<Entry> stats_entries;
+  std::vector<unsigned> stats_order;
+  unsigned stats_mask;
+  unsigned stats_used;
+};
+
+
+#endif  // SOURCESTATS_H